@@ -0,0 +1,377 @@
+#include "board.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Balance analyzer: plays many games per level configuration with a choice
+// of player policies on every core and reports score, best-combo and
+// cascade-length distributions as percentiles, on screen and to CSV.
+// Sweeps over move budgets, policies, board sizes and species counts are
+// comma-separated lists; every combination is one configuration.
+//
+// Usage: analyze [games] [moves,...] [policy,...] [size,...] [species,...] [output.csv] [seed]
+//   e.g. analyze 1000000 5,10,15 random,greedy 8 5,6,7
+
+const int ANALYZE_CHUNK = 512;          // Games per pool task
+const int ANALYZE_MAX_CASCADE = 64;     // Longer cascades are counted as this long
+const int LOOKAHEAD_SAMPLES = 3;        // Refill draws averaged per lookahead candidate
+const float LOOKAHEAD_DISCOUNT = 0.5f;  // Weight of the reply against the swap itself
+
+// A player: picks the next swap on a board with movesLeft swaps to go.
+// Policies may try swaps on copies of the board, reseeded from their own
+// Rng so they never see the real refills coming.
+enum Policy {
+    POLICY_RANDOM,      // Any swap that makes a match
+    POLICY_GREEDY,      // The swap that scores most right now
+    POLICY_LOOKAHEAD,   // The best swap plus the best greedy reply after it
+    POLICY_COUNT
+};
+
+const char* const POLICY_NAMES[POLICY_COUNT] = {"random", "greedy", "lookahead"};
+
+// One point of the sweep
+struct BalanceConfig {
+    int size, species, moves;
+    Policy policy;
+};
+
+// Distributions over the games of one configuration
+struct BalanceStats {
+    vector<int> scores;                             // Final score per game
+    long long bestCombos[ANALYZE_MAX_CASCADE + 1];  // Games by their longest cascade
+    long long cascades[ANALYZE_MAX_CASCADE + 1];    // Scoring swaps by cascade length
+    long long swaps, reshuffles;
+
+    BalanceStats() : bestCombos(), cascades(), swaps(0), reshuffles(0) {}
+
+    void merge(const BalanceStats& other) {
+        scores.insert(scores.end(), other.scores.begin(), other.scores.end());
+        for (int i = 0; i <= ANALYZE_MAX_CASCADE; i++) {
+            bestCombos[i] += other.bestCombos[i];
+            cascades[i] += other.cascades[i];
+        }
+        swaps += other.swaps;
+        reshuffles += other.reshuffles;
+    }
+};
+
+// Summary row of one configuration
+struct BalanceResult {
+    BalanceConfig config;
+    long long games;
+    double meanScore, score[6];     // Percentiles below
+    double combo[3], cascade[3];    // p50, p90, p99
+    double meanCascade, reshufflesPerGame, seconds;
+};
+
+const double SCORE_PERCENTILES[6] = {0.10, 0.25, 0.50, 0.75, 0.90, 0.99};
+const double TAIL_PERCENTILES[3] = {0.50, 0.90, 0.99};
+
+/**
+ * Points a swap scores on a copy of the board with its own refills; the
+ * copy is left after the swap
+ */
+template<typename BoardType>
+static int trySwap(const BoardType& board, const Move& move, Rng& rng, BoardType& trial) {
+    trial = board;
+    trial.rng.seed(uint64_t(rng.next()) << 32 | rng.next());
+    return trial.playSwap(move.row0, move.col0, move.row1, move.col1);
+}
+
+/**
+ * Best immediate score over every move; ties go to the first found
+ */
+template<typename BoardType>
+static int bestGreedy(const BoardType& board, const Move* moves, int count, Rng& rng, int& best) {
+    BoardType trial;
+    int bestPoints = -1;
+    for (int i = 0; i < count; i++) {
+        int points = trySwap(board, moves[i], rng, trial);
+        if (points > bestPoints) {
+            bestPoints = points;
+            best = i;
+        }
+    }
+    return bestPoints;
+}
+
+template<typename BoardType>
+static bool choose(Policy policy, const BoardType& board, int movesLeft, Rng& rng, Move& move) {
+    Move moves[BoardType::MAX_MOVES];
+    int count = board.findMoves(moves);
+    if (!count)
+        return false;
+
+    int best = 0;
+    if (policy == POLICY_RANDOM) {
+        best = rng.below(count);
+    } else if (policy == POLICY_GREEDY || movesLeft <= 1) {
+        bestGreedy(board, moves, count, rng, best);
+    } else {
+        // Each candidate is worth its own points plus the discounted best
+        // reply to the board it leaves, averaged over a few refill draws
+        // so a lucky cascade in one draw does not decide the swap
+        BoardType trial;
+        Move replies[BoardType::MAX_MOVES];
+        float bestPoints = -1;
+        int reply;
+        for (int i = 0; i < count; i++) {
+            float points = 0;
+            for (int sample = 0; sample < LOOKAHEAD_SAMPLES; sample++) {
+                points += trySwap(board, moves[i], rng, trial);
+                int replyCount = trial.findMoves(replies);
+                if (replyCount)
+                    points += LOOKAHEAD_DISCOUNT * bestGreedy(trial, replies, replyCount, rng, reply);
+            }
+            if (points > bestPoints) {
+                bestPoints = points;
+                best = i;
+            }
+        }
+    }
+    move = moves[best];
+    return true;
+}
+
+/**
+ * Plays games [first, first + count) of a configuration; game i always
+ * gets the same seeds, so results do not depend on the thread count
+ */
+template<typename BoardType>
+static void playGames(const BalanceConfig& config, uint64_t seed, long long first, int count, BalanceStats& stats) {
+    BoardType board;
+    for (long long game = first; game < first + count; game++) {
+        Rng rng(seed ^ uint64_t(game) * 0x9E3779B97F4A7C15ULL);
+        board.newGame(uint64_t(rng.next()) << 32 | rng.next());
+
+        for (int swap = 0; swap < config.moves; swap++) {
+            Move move;
+            if (!choose(config.policy, board, config.moves - swap, rng, move))
+                break;
+            int points = board.playSwap(move.row0, move.col0, move.row1, move.col1);
+            stats.swaps++;
+            if (points > 0)
+                stats.cascades[min(board.comboCount, ANALYZE_MAX_CASCADE)]++;
+        }
+
+        stats.scores.push_back(board.totalScore);
+        stats.bestCombos[min(board.maxCombo, ANALYZE_MAX_CASCADE)]++;
+        stats.reshuffles += board.reshuffleCount;
+    }
+}
+
+/**
+ * Value below which the given fraction of counted samples lies
+ */
+static double countPercentile(const long long* counts, int size, double fraction) {
+    long long total = 0;
+    for (int i = 0; i < size; i++)
+        total += counts[i];
+    long long rank = (long long)(fraction * total), seen = 0;
+    for (int i = 0; i < size; i++) {
+        seen += counts[i];
+        if (seen > rank)
+            return i;
+    }
+    return size - 1;
+}
+
+/**
+ * Plays one configuration on the pool, ANALYZE_CHUNK games per task, and
+ * waits for all of them
+ */
+template<typename BoardType>
+static BalanceResult analyze(const BalanceConfig& config, long long games, uint64_t seed, ThreadPool& pool) {
+    auto start = chrono::steady_clock::now();
+
+    BalanceStats total;
+    mutex lock;
+    condition_variable finished;
+    long long chunks = (games + ANALYZE_CHUNK - 1) / ANALYZE_CHUNK, remaining = chunks;
+
+    vector<function<void()>> tasks;
+    for (long long chunk = 0; chunk < chunks; chunk++) {
+        tasks.push_back([&, chunk]() {
+            BalanceStats stats;
+            long long first = chunk * ANALYZE_CHUNK;
+            int count = int(min<long long>(ANALYZE_CHUNK, games - first));
+            stats.scores.reserve(count);
+            playGames<BoardType>(config, seed, first, count, stats);
+
+            lock_guard<mutex> guard(lock);
+            total.merge(stats);
+            if (--remaining == 0)
+                finished.notify_one();
+        });
+    }
+    pool.submit(tasks);
+    {
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [&]() { return remaining == 0; });
+    }
+
+    BalanceResult result = BalanceResult();
+    result.config = config;
+    result.games = games;
+    sort(total.scores.begin(), total.scores.end());
+    double scoreSum = 0;
+    for (int score : total.scores)
+        scoreSum += score;
+    result.meanScore = scoreSum / games;
+    for (int i = 0; i < 6; i++)
+        result.score[i] = total.scores[min<size_t>(size_t(SCORE_PERCENTILES[i] * games), total.scores.size() - 1)];
+
+    long long scoring = 0, cascadeSum = 0;
+    for (int i = 0; i <= ANALYZE_MAX_CASCADE; i++) {
+        scoring += total.cascades[i];
+        cascadeSum += total.cascades[i] * i;
+    }
+    for (int i = 0; i < 3; i++) {
+        result.combo[i] = countPercentile(total.bestCombos, ANALYZE_MAX_CASCADE + 1, TAIL_PERCENTILES[i]);
+        result.cascade[i] = countPercentile(total.cascades, ANALYZE_MAX_CASCADE + 1, TAIL_PERCENTILES[i]);
+    }
+    result.meanCascade = scoring ? double(cascadeSum) / scoring : 0.0;
+    result.reshufflesPerGame = double(total.reshuffles) / games;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/**
+ * True if board.cpp compiles a board of this size and species count
+ */
+static bool boardCompiled(int size, int species) {
+    return species == SPECIES_COUNT ? size >= 8 && size <= 10 : size == 8 && (species == 5 || species == 6);
+}
+
+/**
+ * Runs a configuration on the board it names (one boardCompiled() accepts)
+ */
+static BalanceResult analyzeConfig(const BalanceConfig& config, long long games, uint64_t seed, ThreadPool& pool) {
+    if (config.species == 5)
+        return analyze<BasicBoard<8, 8, 5>>(config, games, seed, pool);
+    if (config.species == 6)
+        return analyze<BasicBoard<8, 8, 6>>(config, games, seed, pool);
+    if (config.size == 9)
+        return analyze<BasicBoard<9, 9, SPECIES_COUNT>>(config, games, seed, pool);
+    if (config.size == 10)
+        return analyze<BasicBoard<10, 10, SPECIES_COUNT>>(config, games, seed, pool);
+    return analyze<BasicBoard<8, 8, SPECIES_COUNT>>(config, games, seed, pool);
+}
+
+/**
+ * Splits a comma-separated list
+ */
+static vector<string> splitList(const string& text) {
+    vector<string> items;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+static bool writeCsv(const string& path, const vector<BalanceResult>& results) {
+    ofstream out(path);
+    if (!out)
+        return false;
+
+    out << "board,species,moves,policy,games,mean_score,score_p10,score_p25,score_p50,score_p75,score_p90,score_p99,"
+        << "combo_p50,combo_p90,combo_p99,cascade_p50,cascade_p90,cascade_p99,mean_cascade,reshuffles_per_game,"
+        << "seconds\n";
+    for (const BalanceResult& r : results) {
+        out << r.config.size << "x" << r.config.size << "," << r.config.species << "," << r.config.moves << ","
+            << POLICY_NAMES[r.config.policy] << "," << r.games << "," << r.meanScore;
+        for (double value : r.score)
+            out << "," << value;
+        for (double value : r.combo)
+            out << "," << value;
+        for (double value : r.cascade)
+            out << "," << value;
+        out << "," << r.meanCascade << "," << r.reshufflesPerGame << "," << r.seconds << "\n";
+    }
+    return bool(out);
+}
+
+int main(int argc, char* argv[]) {
+    long long games = argc > 1 ? atoll(argv[1]) : 100000;
+    vector<string> moveList = splitList(argc > 2 ? argv[2] : to_string(LEVEL1_MOVES));
+    vector<string> policyList = splitList(argc > 3 ? argv[3] : "random,greedy,lookahead");
+    vector<string> sizeList = splitList(argc > 4 ? argv[4] : to_string(BOARD_SIZE));
+    vector<string> speciesList = splitList(argc > 5 ? argv[5] : to_string(SPECIES_COUNT));
+    string outputPath = argc > 6 ? argv[6] : "balance.csv";
+    uint64_t seed = argc > 7 ? strtoull(argv[7], nullptr, 10) : 1;
+    if (games < 1) {
+        cout << "Usage: analyze [games] [moves,...] [policy,...] [size,...] [species,...] [output.csv] [seed]\n";
+        return 1;
+    }
+
+    vector<BalanceConfig> configs;
+    for (const string& size : sizeList) {
+        for (const string& species : speciesList) {
+            if (!boardCompiled(atoi(size.c_str()), atoi(species.c_str()))) {
+                cout << "Skipping " << size << "x" << size << " with " << species
+                     << " species: not compiled into board.cpp\n";
+                continue;
+            }
+            for (const string& moves : moveList) {
+                for (const string& name : policyList) {
+                    int policy = int(find(POLICY_NAMES, POLICY_NAMES + POLICY_COUNT, name) - POLICY_NAMES);
+                    if (policy == POLICY_COUNT) {
+                        cout << "Unknown policy " << name << " (random, greedy or lookahead)\n";
+                        return 1;
+                    }
+                    BalanceConfig config{atoi(size.c_str()), atoi(species.c_str()), atoi(moves.c_str()), Policy(policy)};
+                    if (config.moves < 1) {
+                        cout << "Move budgets must be at least 1\n";
+                        return 1;
+                    }
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+
+    // The whole machine: nothing else runs while analysing
+    ThreadPool pool(int(max(1u, thread::hardware_concurrency())));
+    cout << "Playing " << games << " games for each of " << configs.size() << " configurations on "
+         << pool.size() << " threads\n";
+
+    cout << left << setw(8) << "board" << setw(9) << "species" << setw(7) << "moves" << setw(11) << "policy" << right
+         << setw(10) << "mean" << setw(8) << "p10" << setw(8) << "p50" << setw(8) << "p90" << setw(8) << "p99"
+         << setw(9) << "combo90" << setw(9) << "cascade" << setw(11) << "games/s" << "\n";
+    vector<BalanceResult> results;
+    for (const BalanceConfig& config : configs) {
+        BalanceResult result = analyzeConfig(config, games, seed, pool);
+        results.push_back(result);
+
+        string board = to_string(config.size) + "x" + to_string(config.size);
+        cout << left << setw(8) << board << setw(9) << config.species << setw(7) << config.moves
+             << setw(11) << POLICY_NAMES[config.policy] << right << fixed << setprecision(1)
+             << setw(10) << result.meanScore << setprecision(0) << setw(8) << result.score[0]
+             << setw(8) << result.score[2] << setw(8) << result.score[4] << setw(8) << result.score[5]
+             << setw(9) << result.combo[1] << setprecision(2) << setw(9) << result.meanCascade
+             << setprecision(0) << setw(11) << games / result.seconds << "\n";
+    }
+
+    if (!writeCsv(outputPath, results)) {
+        cout << "Failed to write " << outputPath << "\n";
+        return 1;
+    }
+    cout << "Results written to " << outputPath << "\n";
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include "asset_archive.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char ARCHIVE_MAGIC[4] = {'M', 'P', 'A', 'K'};
+static const uint8_t ARCHIVE_VERSION = 1;
+static const uint8_t KIND_FILE = 0;
+static const uint8_t KIND_REGION = 1;
+static const uint64_t DATA_ALIGNMENT = 16;
+
+/**
+ * Writes an unsigned value of the given byte count, low bytes first
+ */
+static void writeLittle(ofstream& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        out.put(char(value >> (8 * i)));
+}
+
+/**
+ * Bounds-checked little endian reader over the mapped index
+ */
+struct IndexReader {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+
+    bool read(uint64_t& value, int bytes) {
+        if (size - position < size_t(bytes))
+            return false;
+        value = 0;
+        for (int i = 0; i < bytes; i++)
+            value |= uint64_t(data[position++]) << (8 * i);
+        return true;
+    }
+};
+
+AssetArchive::AssetArchive() {
+    mapped = nullptr;
+    mappedSize = 0;
+}
+
+AssetArchive::~AssetArchive() {
+    close();
+}
+
+bool AssetArchive::open(const string& path) {
+    close();
+
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size <= 0) {
+        ::close(file);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* memory = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (memory == MAP_FAILED)
+        return false;
+
+    mapped = static_cast<const uint8_t*>(memory);
+    mappedSize = size_t(info.st_size);
+    if (!readIndex()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetArchive::close() {
+    if (mapped)
+        munmap(const_cast<uint8_t*>(mapped), mappedSize);
+    mapped = nullptr;
+    mappedSize = 0;
+    index.clear();
+}
+
+const void* AssetArchive::data(const string& name, size_t& size) const {
+    const AssetEntry* entry = find(name);
+    if (!entry || entry->region)
+        return nullptr;
+    size = size_t(entry->size);
+    return mapped + entry->offset;
+}
+
+const AssetEntry* AssetArchive::region(const string& name) const {
+    const AssetEntry* entry = find(name);
+    return entry && entry->region ? entry : nullptr;
+}
+
+const vector<AssetEntry>& AssetArchive::entries() const {
+    return index;
+}
+
+bool AssetArchive::write(const string& path, vector<AssetEntry>& entries,
+                         const vector<vector<char>>& contents) {
+    // Index size first, so the data offsets are known before writing it
+    uint64_t indexSize = 4 + 1 + 4;
+    for (const AssetEntry& entry : entries) {
+        if (entry.name.size() > 255)
+            return false;
+        indexSize += 1 + entry.name.size() + 1 + (entry.region ? 8 : 16);
+    }
+
+    uint64_t offset = indexSize;
+    size_t content = 0;
+    for (AssetEntry& entry : entries) {
+        if (entry.region)
+            continue;
+        if (content >= contents.size())
+            return false;
+        offset = (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+        entry.offset = offset;
+        entry.size = contents[content++].size();
+        offset += entry.size;
+    }
+
+    ofstream out(path, ios::binary);
+    if (!out)
+        return false;
+
+    out.write(ARCHIVE_MAGIC, 4);
+    out.put(char(ARCHIVE_VERSION));
+    writeLittle(out, entries.size(), 4);
+    for (const AssetEntry& entry : entries) {
+        out.put(char(entry.name.size()));
+        out.write(entry.name.data(), entry.name.size());
+        if (entry.region) {
+            out.put(char(KIND_REGION));
+            writeLittle(out, entry.x, 2);
+            writeLittle(out, entry.y, 2);
+            writeLittle(out, entry.width, 2);
+            writeLittle(out, entry.height, 2);
+        } else {
+            out.put(char(KIND_FILE));
+            writeLittle(out, entry.offset, 8);
+            writeLittle(out, entry.size, 8);
+        }
+    }
+
+    content = 0;
+    uint64_t written = indexSize;
+    for (const AssetEntry& entry : entries) {
+        if (entry.region)
+            continue;
+        for (; written < entry.offset; written++)
+            out.put(0);
+        const vector<char>& bytes = contents[content++];
+        out.write(bytes.data(), bytes.size());
+        written += bytes.size();
+    }
+    return bool(out);
+}
+
+const AssetEntry* AssetArchive::find(const string& name) const {
+    for (const AssetEntry& entry : index)
+        if (entry.name == name)
+            return &entry;
+    return nullptr;
+}
+
+/**
+ * Parses the index and checks every file member lies inside the mapping
+ */
+bool AssetArchive::readIndex() {
+    if (mappedSize < 9 || !equal(mapped, mapped + 4, ARCHIVE_MAGIC) || mapped[4] != ARCHIVE_VERSION)
+        return false;
+
+    IndexReader reader{mapped, mappedSize, 5};
+    uint64_t count;
+    if (!reader.read(count, 4))
+        return false;
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t length, kind;
+        if (!reader.read(length, 1) || mappedSize - reader.position < length)
+            return false;
+
+        AssetEntry entry = AssetEntry();
+        entry.name.assign(reinterpret_cast<const char*>(mapped + reader.position), size_t(length));
+        reader.position += size_t(length);
+        if (!reader.read(kind, 1))
+            return false;
+
+        if (kind == KIND_REGION) {
+            uint64_t x, y, width, height;
+            if (!reader.read(x, 2) || !reader.read(y, 2) || !reader.read(width, 2) || !reader.read(height, 2))
+                return false;
+            entry.region = true;
+            entry.x = uint16_t(x);
+            entry.y = uint16_t(y);
+            entry.width = uint16_t(width);
+            entry.height = uint16_t(height);
+        } else if (kind == KIND_FILE) {
+            if (!reader.read(entry.offset, 8) || !reader.read(entry.size, 8))
+                return false;
+            if (entry.offset > mappedSize || entry.size > mappedSize - entry.offset)
+                return false;
+        } else {
+            return false;
+        }
+        index.push_back(entry);
+    }
+    return true;
+}
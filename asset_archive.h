@@ -0,0 +1,78 @@
+#ifndef MENAGERIE_ASSET_ARCHIVE_H
+#define MENAGERIE_ASSET_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Packed asset archive: every sprite, sound and font in one indexed file,
+// built by pack_assets. The sprites are packed into a single texture atlas
+// (stored as one PNG) and listed as rectangles of it under their original
+// paths. At runtime the archive is memory-mapped and members are handed to
+// the loaders straight from the mapping. Nothing in here depends on SFML.
+//
+// File layout (little endian):
+//   "MPAK"  u8 version  u32 entry count
+//   per entry:  u8 name length, name, u8 kind
+//     file:    u64 offset (from the start of the archive), u64 size
+//     region:  u16 x, u16 y, u16 width, u16 height (within the atlas)
+//   member data, each starting on a 16-byte boundary
+
+const char* const ATLAS_NAME = "atlas.png";    // The atlas image member
+
+// One member of the archive
+struct AssetEntry {
+    std::string name;
+    bool region;                        // A rectangle of the atlas, no data of its own
+    uint64_t offset, size;              // File members: where the bytes are
+    uint16_t x, y, width, height;       // Regions: the rectangle in the atlas
+};
+
+class AssetArchive {
+public:
+    AssetArchive();
+    ~AssetArchive();
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    /**
+     * Maps an archive into memory and reads its index
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Unmaps the archive; member data handed out before is invalid after this
+     */
+    void close();
+
+    /**
+     * Bytes of a file member, valid until close(); nullptr if there is none
+     */
+    const void* data(const std::string& name, size_t& size) const;
+
+    /**
+     * Rectangle of a packed sprite in the atlas; nullptr if there is none
+     */
+    const AssetEntry* region(const std::string& name) const;
+
+    const std::vector<AssetEntry>& entries() const;
+
+    /**
+     * Writes an archive. File members take their bytes from contents, in
+     * entry order; their offsets and sizes are filled in on the way.
+     */
+    static bool write(const std::string& path, std::vector<AssetEntry>& entries,
+                      const std::vector<std::vector<char>>& contents);
+
+private:
+    const uint8_t* mapped;
+    size_t mappedSize;
+    std::vector<AssetEntry> index;
+
+    const AssetEntry* find(const std::string& name) const;
+    bool readIndex();
+};
+
+#endif
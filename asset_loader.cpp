@@ -0,0 +1,50 @@
+#include "asset_loader.h"
+#include <iostream>
+
+using namespace std;
+
+AssetLoader::AssetLoader(int threadCount) : pool(threadCount) {
+    criticalLeft = 0;
+    totalLeft = 0;
+    criticalFailed = false;
+}
+
+void AssetLoader::add(const string& name, bool critical, function<bool()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        totalLeft++;
+        if (critical)
+            criticalLeft++;
+    }
+
+    pool.submit([this, name, critical, task] {
+        bool loaded = task();
+        if (!loaded)
+            cout << "Failed to load " << name << "\n";
+
+        lock_guard<mutex> guard(lock);
+        if (--totalLeft == 0)
+            allDone.notify_all();
+        if (critical) {
+            criticalFailed = criticalFailed || !loaded;
+            if (--criticalLeft == 0)
+                criticalDone.notify_all();
+        }
+    });
+}
+
+bool AssetLoader::waitCritical() {
+    unique_lock<mutex> guard(lock);
+    criticalDone.wait(guard, [this] { return criticalLeft == 0; });
+    return !criticalFailed;
+}
+
+bool AssetLoader::isDone() {
+    lock_guard<mutex> guard(lock);
+    return totalLeft == 0;
+}
+
+void AssetLoader::waitAll() {
+    unique_lock<mutex> guard(lock);
+    allDone.wait(guard, [this] { return totalLeft == 0; });
+}
@@ -0,0 +1,52 @@
+#ifndef MENAGERIE_ASSET_LOADER_H
+#define MENAGERIE_ASSET_LOADER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "thread_pool.h"
+
+// Decodes startup assets in parallel. Each asset is a task that decodes one
+// archive member into its object and reports success. Critical assets are
+// waited for before the first frame; the rest keep decoding in the
+// background while the start screen is already showing.
+
+class AssetLoader {
+public:
+    /**
+     * threadCount 0 uses every hardware thread but one
+     */
+    explicit AssetLoader(int threadCount = 0);
+
+    /**
+     * Starts decoding an asset; the task returns false if it failed
+     */
+    void add(const std::string& name, bool critical, std::function<bool()> task);
+
+    /**
+     * Blocks until every critical asset is decoded; false if any failed
+     */
+    bool waitCritical();
+
+    /**
+     * True once every asset, critical or not, has been decoded (or failed)
+     */
+    bool isDone();
+
+    /**
+     * Blocks until every asset, critical or not, has been decoded (or failed)
+     */
+    void waitAll();
+
+private:
+    std::mutex lock;
+    std::condition_variable criticalDone;
+    std::condition_variable allDone;
+    int criticalLeft;           // Critical tasks not yet finished
+    int totalLeft;              // All tasks not yet finished
+    bool criticalFailed;
+    ThreadPool pool;            // Last, so the workers stop before the rest goes
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "board.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Microbenchmarks for the board engine: times the match scan, gravity,
+// refill, initial-match clearing and a full swap-to-stable cascade on fixed
+// and random board corpora for every compiled board size, and writes ns/op
+// percentiles to JSON so runs can be compared as the core is optimised.
+//
+// Usage: bench [samples] [output.json]
+
+const int CORPUS_SIZE = 256;    // Boards timed back to back per sample
+
+// Boards of one kind, plus the swap the cascade benchmark plays on each
+template<typename BoardType>
+struct Corpus {
+    string name;
+    vector<BoardType> boards;
+    vector<Move> moves;
+};
+
+// ns/op distribution of one benchmark over all samples
+struct BenchResult {
+    string name;
+    string board;       // Board size, e.g. "8x8"
+    string corpus;
+    double mean, min, p50, p90, p99, max;
+};
+
+// Keeps the optimiser from discarding the work being timed
+static volatile long long sink;
+
+/**
+ * Hand-made layouts covering the extremes: match-free patterns, a board
+ * that is one big match, full-height columns and L/T shapes
+ */
+template<typename BoardType>
+static Corpus<BoardType> fixedCorpus() {
+    const int patternCount = 6;
+    int layouts[patternCount][BoardType::HEIGHT][BoardType::WIDTH];
+    for (int row = 0; row < BoardType::HEIGHT; row++) {
+        for (int col = 0; col < BoardType::WIDTH; col++) {
+            layouts[0][row][col] = (row + col) % BoardType::SPECIES;              // Diagonals, no match
+            layouts[1][row][col] = (row + col) % 2;                               // Two-species checker
+            layouts[2][row][col] = 0;                                             // One species everywhere
+            layouts[3][row][col] = col % BoardType::SPECIES;                      // Full-height columns
+            layouts[4][row][col] = (row % 3 == 0 || col % 3 == 0) ? 1 : (row * 3 + col) % BoardType::SPECIES; // Grid, L/T
+            layouts[5][row][col] = (row / 2 + col / 2) % BoardType::SPECIES;      // 2x2 blocks, no match
+        }
+    }
+
+    Corpus<BoardType> corpus;
+    corpus.name = "fixed";
+    corpus.boards.resize(CORPUS_SIZE);
+    for (int i = 0; i < CORPUS_SIZE; i++) {
+        corpus.boards[i].rng.seed(i + 1);
+        corpus.boards[i].setLayout(layouts[i % patternCount]);
+    }
+    return corpus;
+}
+
+/**
+ * Freshly filled boards, matches included, as refill leaves them
+ */
+template<typename BoardType>
+static Corpus<BoardType> randomCorpus(uint64_t seed) {
+    Corpus<BoardType> corpus;
+    corpus.name = "random";
+    corpus.boards.resize(CORPUS_SIZE);
+    for (int i = 0; i < CORPUS_SIZE; i++) {
+        corpus.boards[i].rng.seed(seed + i);
+        corpus.boards[i].fill();
+    }
+    return corpus;
+}
+
+/**
+ * Match-free boards with a valid swap each, as the player sees them
+ */
+template<typename BoardType>
+static Corpus<BoardType> playableCorpus(uint64_t seed) {
+    Corpus<BoardType> corpus;
+    corpus.name = "playable";
+    corpus.boards.resize(CORPUS_SIZE);
+    corpus.moves.resize(CORPUS_SIZE);
+    for (int i = 0; i < CORPUS_SIZE; i++) {
+        corpus.boards[i].newGame(seed + i);
+        corpus.boards[i].findHint(corpus.moves[i]);
+    }
+    return corpus;
+}
+
+/**
+ * Nearest-rank percentile of sorted samples
+ */
+static double percentile(const vector<double>& sorted, double p) {
+    size_t rank = size_t(p / 100.0 * sorted.size());
+    return sorted[min(rank, sorted.size() - 1)];
+}
+
+/**
+ * Times op over a fresh copy of the corpus per sample; prepare runs on the
+ * copy first and is not timed
+ */
+template<typename BoardType>
+static BenchResult run(const string& name, const Corpus<BoardType>& corpus, int samples,
+                       const function<void(BoardType&)>& prepare,
+                       const function<long long(BoardType&, int)>& op) {
+    vector<BoardType> work;
+    vector<double> nsPerOp;
+    long long checksum = 0;
+
+    for (int sample = 0; sample < samples; sample++) {
+        work = corpus.boards;
+        if (prepare)
+            for (BoardType& board : work)
+                prepare(board);
+
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < work.size(); i++)
+            checksum += op(work[i], int(i));
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        nsPerOp.push_back(ns / work.size());
+    }
+    sink = checksum;
+
+    sort(nsPerOp.begin(), nsPerOp.end());
+    double total = 0;
+    for (double ns : nsPerOp)
+        total += ns;
+
+    BenchResult result;
+    result.name = name;
+    result.board = to_string(BoardType::WIDTH) + "x" + to_string(BoardType::HEIGHT);
+    result.corpus = corpus.name;
+    result.mean = total / nsPerOp.size();
+    result.min = nsPerOp.front();
+    result.p50 = percentile(nsPerOp, 50);
+    result.p90 = percentile(nsPerOp, 90);
+    result.p99 = percentile(nsPerOp, 99);
+    result.max = nsPerOp.back();
+    return result;
+}
+
+static bool writeJson(const string& path, const vector<BenchResult>& results, int samples) {
+    ofstream out(path);
+    if (!out)
+        return false;
+
+    out << "{\n";
+    out << "  \"samples\": " << samples << ",\n";
+    out << "  \"boards_per_sample\": " << CORPUS_SIZE << ",\n";
+    out << "  \"unit\": \"ns/op\",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"board\": \"" << r.board << "\", \"corpus\": \"" << r.corpus << "\", "
+            << "\"mean\": " << r.mean << ", \"min\": " << r.min << ", "
+            << "\"p50\": " << r.p50 << ", \"p90\": " << r.p90 << ", "
+            << "\"p99\": " << r.p99 << ", \"max\": " << r.max << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return bool(out);
+}
+
+/**
+ * Runs every benchmark on the corpora of one board size
+ */
+template<typename BoardType>
+static void benchSize(int samples, vector<BenchResult>& results) {
+    const uint64_t seed = 1;    // Fixed so every run times the same boards
+    Corpus<BoardType> fixedBoards = fixedCorpus<BoardType>();
+    Corpus<BoardType> randomBoards = randomCorpus<BoardType>(seed);
+    Corpus<BoardType> playable = playableCorpus<BoardType>(seed);
+
+    // Operations under test
+    auto scanAll = [](BoardType& board) {
+        board.dirtyRows = BoardType::ALL_ROWS;
+        board.dirtyCols = BoardType::ALL_COLUMNS;
+    };
+    auto matchScan = [](BoardType& board, int) -> long long {
+        return bitCount(board.findMatches());
+    };
+    auto markMatches = [&](BoardType& board) {
+        scanAll(board);
+        board.findMatches();
+    };
+    auto gravity = [](BoardType& board, int) -> long long {
+        board.applyGravity();
+        return board.motion.fall[BoardType::cellIndex(BoardType::HEIGHT, 1)];
+    };
+    auto settle = [&](BoardType& board) {
+        markMatches(board);
+        board.applyGravity();
+    };
+    auto refill = [](BoardType& board, int) -> long long {
+        board.refill();
+        return board.species[0];
+    };
+    auto clearMatches = [](BoardType& board, int) -> long long {
+        board.clearInitialMatches();
+        return board.species[0];
+    };
+    auto generate = [](BoardType& board, int) -> long long {
+        board.generate(START_MIN_MOVES, (BoardType::CELLS + BoardType::SPECIES - 1) / BoardType::SPECIES + START_SPECIES_SLACK);
+        return board.species[0];
+    };
+    auto cascade = [&](BoardType& board, int i) -> long long {
+        const Move& move = playable.moves[i];
+        return board.playSwap(move.row0, move.col0, move.row1, move.col1);
+    };
+
+    for (const Corpus<BoardType>* corpus : {&fixedBoards, &randomBoards, &playable})
+        results.push_back(run<BoardType>("match_scan", *corpus, samples, scanAll, matchScan));
+    for (const Corpus<BoardType>* corpus : {&fixedBoards, &randomBoards}) {
+        results.push_back(run<BoardType>("gravity", *corpus, samples, markMatches, gravity));
+        results.push_back(run<BoardType>("refill", *corpus, samples, settle, refill));
+        results.push_back(run<BoardType>("clear_initial_matches", *corpus, samples, nullptr, clearMatches));
+    }
+    results.push_back(run<BoardType>("generate", randomBoards, samples, nullptr, generate));
+    results.push_back(run<BoardType>("cascade", playable, samples, nullptr, cascade));
+}
+
+int main(int argc, char* argv[]) {
+    int samples = argc > 1 ? atoi(argv[1]) : 200;
+    string outputPath = argc > 2 ? argv[2] : "bench.json";
+    if (samples < 1)
+        samples = 1;
+
+    vector<BenchResult> results;
+    benchSize<BasicBoard<8, 8, SPECIES_COUNT>>(samples, results);
+    benchSize<BasicBoard<9, 9, SPECIES_COUNT>>(samples, results);
+    benchSize<BasicBoard<10, 10, SPECIES_COUNT>>(samples, results);
+
+    cout << left << setw(24) << "benchmark" << setw(8) << "board" << setw(10) << "corpus" << right
+         << setw(10) << "mean" << setw(10) << "p50" << setw(10) << "p90"
+         << setw(10) << "p99" << "  (ns/op)\n";
+    cout << fixed << setprecision(1);
+    for (const BenchResult& r : results) {
+        cout << left << setw(24) << r.name << setw(8) << r.board << setw(10) << r.corpus << right
+             << setw(10) << r.mean << setw(10) << r.p50 << setw(10) << r.p90 << setw(10) << r.p99 << "\n";
+    }
+
+    if (!writeJson(outputPath, results, samples)) {
+        cout << "Failed to write " << outputPath << "\n";
+        return 1;
+    }
+    cout << "Results written to " << outputPath << "\n";
+    return 0;
+}
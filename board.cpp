@@ -0,0 +1,817 @@
+#include "board.h"
+#include "profiler.h"
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+int groupPoints(const MatchGroup& group) {
+    int multiplier = 1;
+    if (group.length >= 5 || group.intersects)
+        multiplier = 5;
+    else if (group.length == 4)
+        multiplier = 4;
+    return group.length * multiplier;
+}
+
+// Zobrist keys per cell and species. They are generated at compile time
+// (SplitMix64 from a fixed seed), so hashes match across processes and are
+// ready before any global Board is constructed. Every board size shares the
+// table, so the game board's keys do not depend on which sizes exist.
+struct ZobristKeys {
+    uint64_t keys[MAX_BOARD_CELLS][MAX_SPECIES];
+
+    constexpr ZobristKeys() : keys() {
+        uint64_t state = 0x5A0B2157ULL;
+        for (int cell = 0; cell < MAX_BOARD_CELLS; cell++) {
+            for (int sp = 0; sp < MAX_SPECIES; sp++) {
+                uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+                value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+                keys[cell][sp] = value ^ (value >> 31);
+            }
+        }
+    }
+};
+
+static constexpr ZobristKeys zobrist;
+
+template<int Width, int Height, int Species>
+uint64_t BasicBoard<Width, Height, Species>::zobristKey(int row, int col, int species) {
+    if (species < 0 || species == EMPTY_CELL)
+        return 0;
+    return zobrist.keys[cellIndex(row, col)][species];
+}
+
+template<int Cells>
+void TileMotion<Cells>::copy(int from, int to) {
+    x[to] = x[from];
+    y[to] = y[from];
+    prevX[to] = prevX[from];
+    prevY[to] = prevY[from];
+    alpha[to] = alpha[from];
+    prevAlpha[to] = prevAlpha[from];
+    fall[to] = fall[from];
+    fromX[to] = fromX[from];
+    fromY[to] = fromY[from];
+    moveTime[to] = moveTime[from];
+    moveDuration[to] = moveDuration[from];
+}
+
+template<int Cells>
+void TileMotion<Cells>::swap(int cell0, int cell1) {
+    std::swap(x[cell0], x[cell1]);
+    std::swap(y[cell0], y[cell1]);
+    std::swap(prevX[cell0], prevX[cell1]);
+    std::swap(prevY[cell0], prevY[cell1]);
+    std::swap(alpha[cell0], alpha[cell1]);
+    std::swap(prevAlpha[cell0], prevAlpha[cell1]);
+    std::swap(fall[cell0], fall[cell1]);
+    std::swap(fromX[cell0], fromX[cell1]);
+    std::swap(fromY[cell0], fromY[cell1]);
+    std::swap(moveTime[cell0], moveTime[cell1]);
+    std::swap(moveDuration[cell0], moveDuration[cell1]);
+}
+
+template<int Cells>
+void TileMotion<Cells>::place(int cell, int tileX, int tileY) {
+    // fromX/fromY/moveTime are set when a move starts
+    x[cell] = prevX[cell] = int16_t(tileX);
+    y[cell] = prevY[cell] = int16_t(tileY);
+    alpha[cell] = prevAlpha[cell] = 255;
+    fall[cell] = 0;
+    moveDuration[cell] = 0;
+}
+
+template<int Width, int Height, int Species>
+BasicBoard<Width, Height, Species>::BasicBoard() {
+    totalScore = 0;
+    comboCount = 0;
+    maxCombo = 0;
+    hasGameStarted = false;
+    reshuffleCount = 0;
+    tickCount = 0;
+    isSwapping = false;
+    isMoving = false;
+    swapRow0 = swapCol0 = swapRow1 = swapCol1 = 0;
+    groupCount = 0;
+    matchMask = 0;
+    tickAccumulator = 0;
+    fadeTime = 0;
+    motion = Motion();
+    for (int cell = 0; cell < CELLS; cell++) {
+        species[cell] = EMPTY_CELL;
+        motion.place(cell, 0, 0);
+    }
+    rebuildMasks();
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::newGame(uint64_t seed) {
+    rng.seed(seed);
+    generate(START_MIN_MOVES, (CELLS + Species - 1) / Species + START_SPECIES_SLACK);
+
+    totalScore = 0;
+    comboCount = 0;
+    maxCombo = 0;
+    hasGameStarted = false;
+    reshuffleCount = 0;
+    tickCount = 0;
+    tickAccumulator = 0;
+    isSwapping = false;
+    isMoving = false;
+    fadeTime = 0;
+}
+
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::generate(int minMoves, int maxPerSpecies) {
+    int layout[Height][Width];
+    bool playable = false;
+    for (int attempt = 0; attempt < GENERATE_ATTEMPTS && !playable; attempt++) {
+        // Every cell that had a safe species leaves the board match-free;
+        // only two species can run out of them
+        Bitboard placed[Species] = {};
+        int counts[Species] = {};
+        int choices[Species];
+        bool clean = true;
+        for (int cell = 0; cell < CELLS; cell++) {
+            Bitboard bit = Bitboard(1) << cell;
+            int choiceCount = safeSpecies(placed, bit, counts, maxPerSpecies, choices);
+            clean = clean && choiceCount > 0;
+            int sp = choiceCount ? choices[rng.below(choiceCount)] : rng.below(Species);
+            layout[cell / Width][cell % Width] = sp;
+            placed[sp] |= bit;
+            counts[sp]++;
+        }
+        setLayout(layout);
+
+        Bitboard horizontalSwaps, verticalSwaps;
+        moveMasks(horizontalSwaps, verticalSwaps);
+        playable = clean && bitCount(horizontalSwaps) + bitCount(verticalSwaps) >= minMoves;
+    }
+    return playable;
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::fill(int speciesCount) {
+    int layout[Height][Width];
+    for (int row = 0; row < Height; row++)
+        for (int col = 0; col < Width; col++)
+            layout[row][col] = rng.below(speciesCount);
+    setLayout(layout);
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::setLayout(const int layout[Height][Width]) {
+    for (int row = 1; row <= Height; row++) {
+        for (int col = 1; col <= Width; col++) {
+            int cell = cellIndex(row, col);
+            int sp = layout[row - 1][col - 1];
+            species[cell] = sp < 0 ? EMPTY_CELL : uint8_t(sp);
+            motion.place(cell, col * TILE_SIZE, row * TILE_SIZE);
+        }
+    }
+    matchMask = 0;
+    groupCount = 0;
+    isSwapping = false;
+    rebuildMasks();
+}
+
+template<int Width, int Height, int Species>
+typename BasicBoard<Width, Height, Species>::PackedBoard BasicBoard<Width, Height, Species>::pack() const {
+    // Bit b of the species of every cell, straight from the species masks;
+    // empty cells get all three bits
+    Bitboard occupied = 0;
+    PackedBoard packed = {{0, 0, 0}};
+    for (int sp = 0; sp < Species; sp++) {
+        occupied |= speciesMask[sp];
+        for (int plane = 0; plane < 3; plane++)
+            if (sp >> plane & 1)
+                packed.planes[plane] |= speciesMask[sp];
+    }
+    for (int plane = 0; plane < 3; plane++)
+        packed.planes[plane] |= FULL & ~occupied;
+    return packed;
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::unpack(const PackedBoard& packed) {
+    int layout[Height][Width];
+    for (int row = 0; row < Height; row++)
+        for (int col = 0; col < Width; col++)
+            layout[row][col] = packed.species(row + 1, col + 1);
+    setLayout(layout);
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::clearInitialMatches() {
+    // Cells are settled in reading order against the masks of the cells
+    // already settled, so only the two tiles to the left and above count
+    for (int sp = 0; sp < Species; sp++)
+        speciesMask[sp] = 0;
+
+    int choices[Species];
+    for (int cell = 0; cell < CELLS; cell++) {
+        uint8_t& sp = species[cell];
+        if (sp == EMPTY_CELL)
+            continue;
+
+        Bitboard bit = Bitboard(1) << cell;
+        if (tripleCells(speciesMask[sp]) & bit) {
+            int choiceCount = safeSpecies(speciesMask, bit, nullptr, 0, choices);
+            if (choiceCount)
+                sp = uint8_t(choices[rng.below(choiceCount)]);
+        }
+        speciesMask[sp] |= bit;
+    }
+    rebuildMasks();
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::swapTiles(int row0, int col0, int row1, int col1) {
+    int cell0 = cellIndex(row0, col0);
+    int cell1 = cellIndex(row1, col1);
+    int species0 = species[cell0];
+    int species1 = species[cell1];
+    if (species0 != species1) {
+        Bitboard both = cellBit(row0, col0) | cellBit(row1, col1);
+        speciesMask[species0] ^= both;
+        speciesMask[species1] ^= both;
+        hash ^= zobristKey(row0, col0, species0) ^ zobristKey(row1, col1, species1) ^
+                zobristKey(row0, col0, species1) ^ zobristKey(row1, col1, species0);
+        markDirty(row0, col0);
+        markDirty(row1, col1);
+    }
+
+    // The tiles trade cells but keep their screen positions, so they
+    // animate across to each other's cell
+    swap(species[cell0], species[cell1]);
+    motion.swap(cell0, cell1);
+    motion.fall[cell0] = motion.fall[cell1] = 0;
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::beginSwap(int row0, int col0, int row1, int col1) {
+    swapTiles(row0, col0, row1, col1);
+    swapRow0 = row0;
+    swapCol0 = col0;
+    swapRow1 = row1;
+    swapCol1 = col1;
+    isSwapping = true;
+    hasGameStarted = true;
+}
+
+template<int Width, int Height, int Species>
+int BasicBoard<Width, Height, Species>::update() {
+    tickCount++;
+
+    // Nothing changed and nothing is animating: no logic work at all
+    if (isIdle())
+        return 0;
+
+    // Tile movement animation: let every tile land before resolving
+    ProfileScope animation(PHASE_ANIMATION);
+    isMoving = stepAnimation();
+    animation.stop();
+    if (isMoving)
+        return 0;
+
+    // Fade out matched tiles, then let the survivors fall and refill
+    if (matchMask) {
+        fadeTime += TICK_SECONDS;
+        isMoving = true;
+        ProfileScope fade(PHASE_FADE);
+        bool fading = fadeMatched();
+        fade.stop();
+        if (!fading) {
+            ProfileScope gravity(PHASE_GRAVITY);
+            applyGravity();
+            gravity.stop();
+
+            ProfileScope newTiles(PHASE_REFILL);
+            refill();
+        }
+        return 0;
+    }
+
+    // Check for matches and update score
+    ProfileScope scan(PHASE_MATCH);
+    findMatches();
+    scan.stop();
+
+    ProfileScope scoring(PHASE_SCORING);
+    fadeTime = 0;
+    int currentMatchPoints = matchPoints(comboCount + 1);
+    if (hasGameStarted)
+        totalScore += currentMatchPoints;
+
+    // Handle invalid swaps
+    if (isSwapping) {
+        if (!currentMatchPoints)
+            swapTiles(swapRow0, swapCol0, swapRow1, swapCol1);
+        isSwapping = false;
+    }
+
+    updateCombo(currentMatchPoints);
+
+    // Dead board: shuffle the same tiles into a playable layout
+    if (!currentMatchPoints && !hasMove())
+        reshuffle();
+
+    return currentMatchPoints;
+}
+
+template<int Width, int Height, int Species>
+int BasicBoard<Width, Height, Species>::advance(float seconds) {
+    // Long stalls are clamped so the ticks never spiral trying to catch up
+    tickAccumulator += min(seconds, MAX_FRAME_SECONDS);
+
+    int points = 0;
+    while (tickAccumulator >= TICK_SECONDS) {
+        points += update();
+        tickAccumulator -= TICK_SECONDS;
+    }
+    return points;
+}
+
+template<int Width, int Height, int Species>
+float BasicBoard<Width, Height, Species>::interpolation() const {
+    return tickAccumulator / TICK_SECONDS;
+}
+
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::isIdle() const {
+    return !dirtyRows && !dirtyCols && !matchMask && !isMoving && !isSwapping && !comboCount;
+}
+
+template<int Width, int Height, int Species>
+int BasicBoard<Width, Height, Species>::playSwap(int row0, int col0, int row1, int col1) {
+    swapTiles(row0, col0, row1, col1);
+    findMatches();
+
+    if (!groupCount) {
+        swapTiles(row0, col0, row1, col1);
+        return 0;
+    }
+
+    // Resolve the cascade: clear -> fall -> refill -> re-match
+    int gained = 0;
+    comboCount = 0;
+    while (groupCount) {
+        comboCount++;
+        gained += matchPoints(comboCount);
+        applyGravity();
+        refill();
+        findMatches();
+    }
+    maxCombo = max(maxCombo, comboCount);
+
+    if (!hasMove())
+        reshuffle();
+
+    hasGameStarted = true;
+    totalScore += gained;
+
+    // Tiles keep their pre-swap screen positions, so update() replays the
+    // swap and the falls as one animation
+    isMoving = true;
+    return gained;
+}
+
+template<int Width, int Height, int Species>
+typename BasicBoard<Width, Height, Species>::Bitboard BasicBoard<Width, Height, Species>::findMatches() {
+    // A horizontal triple may only start two or more columns before the end
+    // of a row, otherwise the shifted masks would wrap into the next row
+    const Bitboard tripleStarts = NOT_LAST_TWO_COLUMNS;
+
+    // Only runs lying in a dirty row (horizontal) or dirty column (vertical)
+    // can be new; everything else was already checked and found stable
+    Bitboard rowFilter = 0;
+    for (int row = 0; row < Height; row++)
+        if (dirtyRows >> row & 1)
+            rowFilter |= FIRST_ROW << (row * Width);
+    Bitboard colFilter = Bitboard(dirtyCols) * FIRST_COLUMN;
+    dirtyRows = dirtyCols = 0;
+
+    Bitboard matches = 0;
+    groupCount = 0;
+    for (int sp = 0; sp < Species && (rowFilter | colFilter); sp++) {
+        Bitboard mask = speciesMask[sp];
+        Bitboard horizontal = mask & (mask >> 1) & (mask >> 2) & tripleStarts & rowFilter;
+        Bitboard vertical = mask & (mask >> Width) & (mask >> 2 * Width) & colFilter;
+        if (!(horizontal | vertical))
+            continue;
+
+        Bitboard horizontalRuns = horizontal | (horizontal << 1) | (horizontal << 2);
+        Bitboard verticalRuns = vertical | (vertical << Width) | (vertical << 2 * Width);
+        matches |= horizontalRuns | verticalRuns;
+        extractRuns(sp, horizontalRuns, verticalRuns);
+    }
+
+    matchMask = matches;
+    return matches;
+}
+
+template<int Width, int Height, int Species>
+int BasicBoard<Width, Height, Species>::matchPoints(int cascadeStep) const {
+    if (!groupCount)
+        return 0;
+
+    int points = (cascadeStep - 1) * COMBO_BONUS;
+    for (int i = 0; i < groupCount; i++)
+        points += groupPoints(groups[i]);
+    return points;
+}
+
+template<int Width, int Height, int Species>
+int BasicBoard<Width, Height, Species>::findMoves(Move* moves) const {
+    Bitboard horizontalSwaps, verticalSwaps;
+    moveMasks(horizontalSwaps, verticalSwaps);
+
+    int count = 0;
+    for (; horizontalSwaps; horizontalSwaps &= horizontalSwaps - 1) {
+        int index = bitScan(horizontalSwaps);
+        int row = index / Width + 1, col = index % Width + 1;
+        moves[count++] = Move{row, col, row, col + 1};
+    }
+    for (; verticalSwaps; verticalSwaps &= verticalSwaps - 1) {
+        int index = bitScan(verticalSwaps);
+        int row = index / Width + 1, col = index % Width + 1;
+        moves[count++] = Move{row, col, row + 1, col};
+    }
+    return count;
+}
+
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::hasMove() const {
+    Bitboard horizontalSwaps, verticalSwaps;
+    moveMasks(horizontalSwaps, verticalSwaps);
+    return (horizontalSwaps | verticalSwaps) != 0;
+}
+
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::findHint(Move& hint) const {
+    Move moves[MAX_MOVES];
+    int count = findMoves(moves);
+    if (!count)
+        return false;
+
+    // Vary the hint without drawing from the session RNG, so asking for
+    // hints never changes how a recorded session plays out
+    hint = moves[tickCount % count];
+    return true;
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::reshuffle() {
+    int pool[CELLS];
+    int poolSize = 0;
+    for (int cell = 0; cell < CELLS; cell++)
+        pool[poolSize++] = species[cell];
+
+    // Retry until the layout is match-free and playable; if every attempt
+    // fails the last layout stands and the cascade sorts it out
+    for (int attempt = 0; attempt < RESHUFFLE_ATTEMPTS; attempt++) {
+        if (placeShuffled(pool, poolSize) && hasMove())
+            break;
+    }
+    reshuffleCount++;
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::applyGravity() {
+    if (!matchMask)
+        return;
+
+    for (int col = 1; col <= Width; col++) {
+        Bitboard column = FIRST_COLUMN << (col - 1);
+        if (!(matchMask & column)) {
+            for (int row = 1; row <= Height; row++)
+                motion.fall[cellIndex(row, col)] = 0;
+            continue;
+        }
+
+        // Compact the column: each surviving tile moves down once, straight
+        // to its final row, and remembers how far it fell
+        for (int sp = 0; sp < Species; sp++)
+            speciesMask[sp] &= ~column;
+
+        int writeRow = Height;
+        for (int row = Height; row > 0; row--) {
+            int cell = cellIndex(row, col);
+            int sp = species[cell];
+            if (matchMask >> cell & 1) {
+                hash ^= zobristKey(row, col, sp);
+                continue;
+            }
+
+            int target = cellIndex(writeRow, col);
+            motion.fall[cell] = uint8_t(writeRow - row);
+            if (writeRow != row) {
+                hash ^= zobristKey(row, col, sp) ^ zobristKey(writeRow, col, sp);
+                species[target] = uint8_t(sp);
+                motion.copy(cell, target);
+                markDirty(writeRow, col);
+            }
+            speciesMask[sp] |= Bitboard(1) << target;
+            writeRow--;
+        }
+
+        // The rows left at the top are holes for refill()
+        for (int row = writeRow; row > 0; row--) {
+            int cell = cellIndex(row, col);
+            species[cell] = EMPTY_CELL;
+            emptyMask |= Bitboard(1) << cell;
+            markDirty(row, col);
+        }
+    }
+}
+
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::refill() {
+    if (!matchMask)
+        return;
+
+    for (int col = 1; col <= Width; col++) {
+        int holes = bitCount(emptyMask & (FIRST_COLUMN << (col - 1)));
+
+        // New tiles stack up above the board and drop in by the hole count
+        for (int row = 1; row <= holes; row++) {
+            int cell = cellIndex(row, col);
+            int sp = rng.below(Species);
+            species[cell] = uint8_t(sp);
+            motion.place(cell, col * TILE_SIZE, (row - holes) * TILE_SIZE);
+            motion.fall[cell] = uint8_t(holes);
+            speciesMask[sp] |= Bitboard(1) << cell;
+            hash ^= zobristKey(row, col, sp);
+        }
+    }
+    emptyMask = 0;
+    matchMask = 0;
+}
+
+/**
+ * Moves every tile one tick along its eased path towards its grid position.
+ * Swapped tiles ease in and out; falling tiles accelerate. Returns true while
+ * any tile is still travelling.
+ */
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::stepAnimation() {
+    copy(begin(motion.x), end(motion.x), motion.prevX);
+    copy(begin(motion.y), end(motion.y), motion.prevY);
+    copy(begin(motion.alpha), end(motion.alpha), motion.prevAlpha);
+
+    bool moving = false;
+    for (int cell = 0; cell < CELLS; cell++) {
+        int targetX = (cell % Width + 1) * TILE_SIZE;
+        int targetY = (cell / Width + 1) * TILE_SIZE;
+        int x = motion.x[cell], y = motion.y[cell];
+        if (x == targetX && y == targetY)
+            continue;
+
+        // Start a new move from wherever the tile is now
+        if (motion.moveDuration[cell] == 0) {
+            motion.fromX[cell] = int16_t(x);
+            motion.fromY[cell] = int16_t(y);
+            motion.moveTime[cell] = 0;
+            motion.moveDuration[cell] = (abs(targetX - x) + abs(targetY - y)) / MOVE_SPEED;
+        }
+
+        motion.moveTime[cell] += TICK_SECONDS;
+        float t = min(motion.moveTime[cell] / motion.moveDuration[cell], 1.0f);
+        float eased = motion.fall[cell] ? t * t : t * t * (3 - 2 * t);
+
+        if (t < 1) {
+            int fromX = motion.fromX[cell], fromY = motion.fromY[cell];
+            motion.x[cell] = int16_t(fromX + int((targetX - fromX) * eased));
+            motion.y[cell] = int16_t(fromY + int((targetY - fromY) * eased));
+            moving = true;
+        } else {
+            // Landed: the board may go idle before the next step, so the
+            // previous position is settled too or the tile renders off-grid
+            motion.x[cell] = motion.prevX[cell] = int16_t(targetX);
+            motion.y[cell] = motion.prevY[cell] = int16_t(targetY);
+            motion.moveDuration[cell] = 0;
+        }
+    }
+    return moving;
+}
+
+/**
+ * Fades matched tiles out over FADE_SECONDS. Returns true while any tile is
+ * still fading.
+ */
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::fadeMatched() {
+    float t = min(fadeTime / FADE_SECONDS, 1.0f);
+    int alpha = int(255 * (1 - t * t));
+
+    for (Bitboard bits = matchMask; bits; bits &= bits - 1)
+        motion.alpha[bitScan(bits)] = uint8_t(alpha);
+    return t < 1;
+}
+
+/**
+ * Combo handling: counts the cascade steps that scored since the last swap
+ * and reports the chain once the board settles
+ */
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::updateCombo(int currentMatchPoints) {
+    if (currentMatchPoints > 0) {
+        comboCount++;
+        maxCombo = max(maxCombo, comboCount);
+    } else if (!isMoving && !isSwapping) {
+        if (comboCount > 1)
+            cout << "Combo x" << comboCount << "!\n";
+        comboCount = 0;
+    }
+}
+
+/**
+ * Finds all swaps that complete a triple, as two masks keyed by the left
+ * tile (horizontal swaps) and the top tile (vertical swaps).
+ *
+ * For each species, a cell that is not of that species completes a triple
+ * if it has a pair beside it or sits in a gap between two. A tile of the
+ * species may move in from any neighbour that is not part of that pattern.
+ */
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::moveMasks(Bitboard& horizontalSwaps, Bitboard& verticalSwaps) const {
+    horizontalSwaps = verticalSwaps = 0;
+    for (int sp = 0; sp < Species; sp++) {
+        Bitboard mask = speciesMask[sp];
+
+        // Cells whose neighbour on that side is of this species
+        Bitboard leftIs = (mask << 1) & NOT_FIRST_COLUMN;
+        Bitboard rightIs = (mask >> 1) & NOT_LAST_COLUMN;
+        Bitboard aboveIs = mask << Width;
+        Bitboard belowIs = mask >> Width;
+
+        Bitboard leftPair = leftIs & (mask << 2) & NOT_FIRST_TWO_COLUMNS;
+        Bitboard rightPair = rightIs & (mask >> 2) & NOT_LAST_TWO_COLUMNS;
+        Bitboard rowGap = leftIs & rightIs;
+        Bitboard abovePair = aboveIs & (mask << 2 * Width);
+        Bitboard belowPair = belowIs & (mask >> 2 * Width);
+        Bitboard columnGap = aboveIs & belowIs;
+
+        Bitboard rowPatterns = leftPair | rightPair | rowGap;
+        Bitboard viaRight = (leftPair | abovePair | belowPair | columnGap) & rightIs & ~mask;
+        Bitboard viaLeft = (rightPair | abovePair | belowPair | columnGap) & leftIs & ~mask;
+        Bitboard viaAbove = (rowPatterns | belowPair) & aboveIs & ~mask;
+        Bitboard viaBelow = (rowPatterns | abovePair) & belowIs & ~mask;
+
+        horizontalSwaps |= viaRight | (viaLeft >> 1);
+        verticalSwaps |= viaBelow | (viaAbove >> Width);
+    }
+}
+
+/**
+ * Deals the pool of species onto the board in random order, steering each
+ * cell away from species that would complete a triple. Returns false if
+ * some cell had no such choice left.
+ */
+template<int Width, int Height, int Species>
+bool BasicBoard<Width, Height, Species>::placeShuffled(int* pool, int poolSize) {
+    for (int i = poolSize - 1; i > 0; i--)
+        swap(pool[i], pool[rng.below(i + 1)]);
+
+    for (int sp = 0; sp < Species; sp++)
+        speciesMask[sp] = 0;
+
+    bool clean = true;
+    for (int i = 0; i < poolSize; i++) {
+        Bitboard bit = Bitboard(1) << i;
+
+        int pick = i;
+        for (; pick < poolSize; pick++)
+            if (!(tripleCells(speciesMask[pool[pick]]) & bit))
+                break;
+        if (pick == poolSize) {
+            pick = i;
+            clean = false;
+        }
+
+        swap(pool[i], pool[pick]);
+        species[i] = uint8_t(pool[i]);
+        speciesMask[pool[i]] |= bit;
+    }
+
+    rebuildMasks();
+    return clean;
+}
+
+/**
+ * Lists the species a cell can take without completing a triple with the
+ * settled tiles in masks, skipping species whose counts reached
+ * maxPerSpecies (if set) unless that leaves nothing. Returns how many.
+ */
+template<int Width, int Height, int Species>
+int BasicBoard<Width, Height, Species>::safeSpecies(const Bitboard* masks, Bitboard bit, const int* counts,
+                                                   int maxPerSpecies, int* choices) {
+    int choiceCount = 0;
+    for (int sp = 0; sp < Species; sp++)
+        if (!(tripleCells(masks[sp]) & bit) && (!maxPerSpecies || counts[sp] < maxPerSpecies))
+            choices[choiceCount++] = sp;
+    if (choiceCount == 0 && maxPerSpecies)
+        return safeSpecies(masks, bit, counts, 0, choices);
+    return choiceCount;
+}
+
+/**
+ * Recomputes the species masks, the holes and the hash from the species
+ */
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::rebuildMasks() {
+    for (int sp = 0; sp < Species; sp++)
+        speciesMask[sp] = 0;
+    emptyMask = 0;
+    hash = 0;
+
+    for (int cell = 0; cell < CELLS; cell++) {
+        int sp = species[cell];
+        if (sp == EMPTY_CELL) {
+            emptyMask |= Bitboard(1) << cell;
+            continue;
+        }
+        speciesMask[sp] |= Bitboard(1) << cell;
+        hash ^= zobrist.keys[cell][sp];
+    }
+
+    dirtyRows = ALL_ROWS;
+    dirtyCols = ALL_COLUMNS;
+}
+
+/**
+ * Cells that would complete a triple with two tiles of the mask directly to
+ * their left or directly above; the bounds mask keeps row ends from wrapping
+ */
+template<int Width, int Height, int Species>
+typename BasicBoard<Width, Height, Species>::Bitboard BasicBoard<Width, Height, Species>::tripleCells(Bitboard mask) {
+    return ((mask << 1) & (mask << 2) & NOT_FIRST_TWO_COLUMNS) |
+           ((mask << Width) & (mask << 2 * Width));
+}
+
+/**
+ * Flags the row and column of a changed tile for re-matching
+ */
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::markDirty(int row, int col) {
+    dirtyRows |= uint16_t(1 << (row - 1));
+    dirtyCols |= uint16_t(1 << (col - 1));
+}
+
+/**
+ * Splits the matched cells of one species into straight runs, walking each
+ * run once from its first tile
+ */
+template<int Width, int Height, int Species>
+void BasicBoard<Width, Height, Species>::extractRuns(int species, Bitboard horizontalRuns, Bitboard verticalRuns) {
+    // A run starts where the tile to the left (or above) is not in a run
+    Bitboard starts = horizontalRuns & ~((horizontalRuns << 1) & NOT_FIRST_COLUMN);
+    for (; starts; starts &= starts - 1) {
+        int index = bitScan(starts);
+        int row = index / Width, col = index % Width;
+        unsigned rowBits = unsigned(horizontalRuns >> (row * Width) & FIRST_ROW);
+        int length = __builtin_ctz(~(rowBits >> col));
+        Bitboard cells = ((Bitboard(1) << length) - 1) << index;
+
+        MatchGroup& group = groups[groupCount++];
+        group.species = species;
+        group.row = row + 1;
+        group.col = col + 1;
+        group.length = length;
+        group.horizontal = true;
+        group.intersects = (cells & verticalRuns) != 0;
+    }
+
+    starts = verticalRuns & ~(verticalRuns << Width);
+    for (; starts; starts &= starts - 1) {
+        int index = bitScan(starts);
+        Bitboard cells = 0;
+        int length = 0;
+        for (int i = index; i < CELLS && (verticalRuns >> i & 1); i += Width) {
+            cells |= Bitboard(1) << i;
+            length++;
+        }
+
+        MatchGroup& group = groups[groupCount++];
+        group.species = species;
+        group.row = index / Width + 1;
+        group.col = index % Width + 1;
+        group.length = length;
+        group.horizontal = false;
+        group.intersects = (cells & horizontalRuns) != 0;
+    }
+}
+
+template struct TileMotion<8 * 8>;
+template struct TileMotion<9 * 9>;
+template struct TileMotion<10 * 10>;
+template struct TileMotion<10 * 8>;
+template class BasicBoard<8, 8, SPECIES_COUNT>;
+template class BasicBoard<8, 8, 5>;
+template class BasicBoard<8, 8, 6>;
+template class BasicBoard<9, 9, SPECIES_COUNT>;
+template class BasicBoard<10, 10, SPECIES_COUNT>;
+template class BasicBoard<10, 8, SPECIES_COUNT>;
@@ -0,0 +1,411 @@
+#ifndef MENAGERIE_BOARD_H
+#define MENAGERIE_BOARD_H
+
+#include <cstdint>
+#include <type_traits>
+#include "rng.h"
+
+// Headless game engine: board state, matching, gravity, refill and scoring.
+// Nothing in here depends on SFML, so it can be driven by the game window,
+// by the batch simulator, or by any other tool that has no display.
+//
+// The board is a template on its width, height and species count, so loop
+// bounds and bounds masks are compile-time constants in every instance.
+// board.cpp instantiates the 8x8 game board plus 9x9 and 10x10 variants,
+// 8x8 boards with 5 and 6 species for balance sweeps, and a non-square
+// 10x8 board that keeps row and column handling apart in the checks.
+
+// Board constants
+const int BOARD_SIZE = 8;       // Playable tiles per row/column of the game board
+const int SPECIES_COUNT = 7;    // Number of animal species
+const int TILE_SIZE = 54;       // Tile pitch in pixels (used for animation)
+
+// Limits of the board template
+const int MAX_BOARD_SIDE = 16;      // Dirty rows/columns are 16-bit masks
+const int MAX_BOARD_CELLS = 128;    // Widest bitboard is 128 bits
+const int MAX_SPECIES = 7;          // Packed species are 3 bits, 7 = empty
+
+// Timing constants: logic runs at a fixed tick, independent of frame rate
+const int TICK_RATE = 120;                  // Logic ticks per second
+const float TICK_SECONDS = 1.0f / TICK_RATE;
+const float MAX_FRAME_SECONDS = 0.25f;      // Longest frame the ticks catch up on
+const float MOVE_SPEED = 600.0f;            // Mean tile speed in pixels per second
+const float FADE_SECONDS = 0.4f;            // Time for a matched tile to fade out
+
+// Level rules
+const int LEVEL1_MOVES = 10;            // Swaps allowed on level 1
+const float LEVEL2_SECONDS = 30.0f;     // Time limit of level 2
+
+// Scoring constants
+const int COMBO_BONUS = 10;     // Extra points per cascade step after the first
+const int RESHUFFLE_ATTEMPTS = 100; // Tries at a match-free, playable layout
+
+// New boards: match-free, with a few moves and no species far over its share
+const int START_MIN_MOVES = 3;          // Swaps that make a match on every new board
+const int START_SPECIES_SLACK = 3;      // Tiles of one species allowed over an even share
+const int GENERATE_ATTEMPTS = 100;      // Layouts tried before settling for the last one
+
+const uint8_t EMPTY_CELL = 0xFF;    // Species of a cell with no tile
+
+// Bitboards: bit (row - 1) * width + (col - 1) is the playable cell
+// (row, col). Boards of up to 64 cells use a plain 64-bit mask.
+__extension__ typedef unsigned __int128 Bitboard128;
+
+template<int Cells>
+using BitboardFor = typename std::conditional<(Cells <= 64), uint64_t, Bitboard128>::type;
+
+/**
+ * Index of the lowest set bit; the mask must not be empty
+ */
+inline int bitScan(uint64_t bits) {
+    return __builtin_ctzll(bits);
+}
+
+inline int bitScan(Bitboard128 bits) {
+    uint64_t low = uint64_t(bits);
+    return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll(uint64_t(bits >> 64));
+}
+
+inline int bitCount(uint64_t bits) {
+    return __builtin_popcountll(bits);
+}
+
+inline int bitCount(Bitboard128 bits) {
+    return __builtin_popcountll(uint64_t(bits)) + __builtin_popcountll(uint64_t(bits >> 64));
+}
+
+// Animation state of the tile on each cell, one array per field in cell
+// order, so the animation step and the renderer stream through only the
+// fields they use and the logic never touches them
+template<int Cells>
+struct TileMotion {
+    int16_t x[Cells], y[Cells];             // Screen position
+    int16_t prevX[Cells], prevY[Cells];     // Position at the previous tick (for interpolation)
+    uint8_t alpha[Cells];                   // Transparency
+    uint8_t prevAlpha[Cells];
+    uint8_t fall[Cells];                    // Rows dropped by the last gravity step
+    int16_t fromX[Cells], fromY[Cells];     // Where the current move started
+    float moveTime[Cells];                  // Progress of the current move
+    float moveDuration[Cells];              // 0 = not moving
+
+    /**
+     * Copies every field of one cell's tile to another cell
+     */
+    void copy(int from, int to);
+
+    void swap(int cell0, int cell1);
+
+    /**
+     * Places a tile at rest at a screen position
+     */
+    void place(int cell, int tileX, int tileY);
+};
+
+// Species layout in 3 bitboards: planes[b] holds bit b of every cell's
+// species (cells in bitboard order, 3 bits each); empty cells read as 7
+template<int Width, int Height>
+struct BasicPackedBoard {
+    BitboardFor<Width * Height> planes[3];
+
+    /**
+     * Species at a playable cell, -1 if it is empty
+     */
+    int species(int row, int col) const {
+        int index = (row - 1) * Width + (col - 1);
+        int value = int((planes[0] >> index & 1) | (planes[1] >> index & 1) << 1 | (planes[2] >> index & 1) << 2);
+        return value == 7 ? -1 : value;
+    }
+
+    void setSpecies(int row, int col, int species) {
+        BitboardFor<Width * Height> bit = BitboardFor<Width * Height>(1) << ((row - 1) * Width + (col - 1));
+        int value = species < 0 ? 7 : species;
+        for (int plane = 0; plane < 3; plane++)
+            planes[plane] = (value >> plane & 1) ? planes[plane] | bit : planes[plane] & ~bit;
+    }
+
+    bool operator==(const BasicPackedBoard& other) const {
+        return planes[0] == other.planes[0] && planes[1] == other.planes[1] && planes[2] == other.planes[2];
+    }
+};
+
+// A straight run of 3 or more tiles of one species
+struct MatchGroup {
+    int species;        // Type of animal
+    int row, col;       // First tile (leftmost or topmost)
+    int length;         // Number of tiles in the run
+    bool horizontal;    // Orientation
+    bool intersects;    // Shares a tile with a run in the other direction (L/T)
+};
+
+// A swap of two adjacent tiles (row0, col0) <-> (row1, col1)
+struct Move {
+    int row0, col0;
+    int row1, col1;
+};
+
+/**
+ * Points for one run: chains of 3 score base points, 4 score x4 and 5 or
+ * more (or any run forming an L/T shape) score x5
+ */
+int groupPoints(const MatchGroup& group);
+
+template<int Width, int Height, int Species>
+class BasicBoard {
+public:
+    static_assert(Width >= 3 && Height >= 3, "a triple must fit in a row and a column");
+    static_assert(Width <= MAX_BOARD_SIDE && Height <= MAX_BOARD_SIDE, "dirty rows/columns are 16-bit masks");
+    static_assert(Width * Height <= MAX_BOARD_CELLS, "bitboards hold at most 128 cells");
+    static_assert(Species >= 2 && Species <= MAX_SPECIES, "packed species are 3 bits");
+
+    typedef BitboardFor<Width * Height> Bitboard;
+    typedef TileMotion<Width * Height> Motion;
+    typedef BasicPackedBoard<Width, Height> PackedBoard;
+
+    static constexpr int WIDTH = Width;
+    static constexpr int HEIGHT = Height;
+    static constexpr int SPECIES = Species;
+    static constexpr int CELLS = Width * Height;
+
+    static constexpr int MAX_MATCH_GROUPS = Height * (Width / 3) + Width * (Height / 3); // Runs of 3 per row and column
+    static constexpr int MAX_MOVES = Height * (Width - 1) + Width * (Height - 1);       // Every adjacent pair
+
+    // Bounds masks: every cell, the first column, and cells with at least
+    // one/two columns to their left or right
+    static constexpr Bitboard FULL = ~Bitboard(0) >> (8 * sizeof(Bitboard) - CELLS);
+    static constexpr Bitboard FIRST_ROW = (Bitboard(1) << Width) - 1;
+    static constexpr Bitboard FIRST_COLUMN = FULL / FIRST_ROW;
+    static constexpr Bitboard NOT_FIRST_COLUMN = FULL & ~FIRST_COLUMN;
+    static constexpr Bitboard NOT_FIRST_TWO_COLUMNS = FULL & ~(FIRST_COLUMN | FIRST_COLUMN << 1);
+    static constexpr Bitboard NOT_LAST_COLUMN = FULL & ~(FIRST_COLUMN << (Width - 1));
+    static constexpr Bitboard NOT_LAST_TWO_COLUMNS = FULL & ~(FIRST_COLUMN << (Width - 2) | FIRST_COLUMN << (Width - 1));
+    static constexpr uint16_t ALL_ROWS = uint16_t((1 << Height) - 1);
+    static constexpr uint16_t ALL_COLUMNS = uint16_t((1 << Width) - 1);
+
+    // Logic state, one entry per playable cell in cell order
+    uint8_t species[CELLS];                    // Type of animal (EMPTY_CELL for a hole)
+    Bitboard speciesMask[Species];             // Occupancy mask per species
+    Bitboard emptyMask;                        // Holes left by gravity until refill
+    uint64_t hash;                             // Zobrist hash of the layout, kept up to date
+
+    // Screen-side state of the tiles
+    Motion motion;
+
+    // Runs found by the last findMatches(); matchMask flags their tiles
+    MatchGroup groups[MAX_MATCH_GROUPS];
+    int groupCount;
+    Bitboard matchMask;
+
+    // Rows/columns changed since the last findMatches() (bit 0 = row/col 1)
+    uint16_t dirtyRows;
+    uint16_t dirtyCols;
+
+    // Score and combo state
+    int totalScore;
+    int comboCount;
+    int maxCombo;
+    bool hasGameStarted;
+    int reshuffleCount;     // Dead boards shuffled so far
+
+    // Session state: every random draw comes from rng, so the seed and the
+    // tick of each swap reproduce a session exactly
+    Rng rng;
+    uint32_t tickCount;     // Logic ticks run since newGame()
+
+    // Animation state
+    bool isSwapping;
+    bool isMoving;
+
+    BasicBoard();
+
+    /**
+     * Index of a playable cell in the per-cell arrays and bitboards
+     */
+    static int cellIndex(int row, int col) {
+        return (row - 1) * Width + (col - 1);
+    }
+
+    static Bitboard cellBit(int row, int col) {
+        return Bitboard(1) << cellIndex(row, col);
+    }
+
+    /**
+     * Zobrist key of a species on a playable cell; a board's hash is the XOR
+     * of the keys of all its tiles (empty cells add nothing)
+     */
+    static uint64_t zobristKey(int row, int col, int species);
+
+    /**
+     * Species at a playable cell, -1 for a hole
+     */
+    int speciesAt(int row, int col) const {
+        uint8_t value = species[cellIndex(row, col)];
+        return value == EMPTY_CELL ? -1 : value;
+    }
+
+    /**
+     * Seeds the RNG and starts a fresh game: a generate()d board with
+     * START_MIN_MOVES moves, zero score, tick counter back to 0
+     */
+    void newGame(uint64_t seed);
+
+    /**
+     * Builds a match-free board cell by cell: each cell draws uniformly from
+     * the species that complete no triple with the tiles to its left and
+     * above and, if maxPerSpecies is set, are still under that count.
+     * Layouts with fewer than minMoves moves are drawn again, up to
+     * GENERATE_ATTEMPTS times; returns false if none had enough (the last
+     * one stands).
+     */
+    bool generate(int minMoves, int maxPerSpecies = 0);
+
+    /**
+     * Fills the board with random species and snaps every tile into place
+     */
+    void fill(int speciesCount = Species);
+
+    /**
+     * Places the given species (row-major, playable cells only) on the
+     * board and snaps every tile into place
+     */
+    void setLayout(const int layout[Height][Width]);
+
+    /**
+     * The species layout in 3 bitboards (24 bytes on the game board)
+     */
+    PackedBoard pack() const;
+
+    /**
+     * Places a packed layout on the board, as setLayout()
+     */
+    void unpack(const PackedBoard& packed);
+
+    /**
+     * Replaces every tile that completes a three-in-a-row with a species
+     * drawn from those that complete none
+     */
+    void clearInitialMatches();
+
+    /**
+     * Swaps two tiles on the game board
+     */
+    void swapTiles(int row0, int col0, int row1, int col1);
+
+    /**
+     * Starts an animated player swap; update() reverts it if nothing matches
+     */
+    void beginSwap(int row0, int col0, int row1, int col1);
+
+    /**
+     * Runs one fixed logic tick and returns the match points found this
+     * tick. Does nothing while the board is idle.
+     */
+    int update();
+
+    /**
+     * Runs as many ticks as fit into the elapsed frame time and returns
+     * the match points found; the remainder carries over to the next frame
+     */
+    int advance(float seconds);
+
+    /**
+     * How far the frame is between the last tick and the next one (0..1),
+     * for drawing tiles between their previous and current positions
+     */
+    float interpolation() const;
+
+    /**
+     * True when nothing is dirty, moving, swapping or mid-combo
+     */
+    bool isIdle() const;
+
+    /**
+     * Plays a swap to completion without animation: swaps, resolves the whole
+     * cascade and returns the points scored (0 if the swap was reverted).
+     * The next update() calls replay the resulting moves as one animation.
+     */
+    int playSwap(int row0, int col0, int row1, int col1);
+
+    /**
+     * Finds every horizontal and vertical triple with shift-and-AND on the
+     * species masks, flags the matched tiles, extracts the runs into groups
+     * and returns the match mask. Only dirty rows and columns are checked.
+     */
+    Bitboard findMatches();
+
+    /**
+     * Points for the groups of the last findMatches(), including the combo
+     * bonus for the given cascade step (1 = direct result of the swap)
+     */
+    int matchPoints(int cascadeStep = 1) const;
+
+    /**
+     * Lists every swap that produces a match (up to MAX_MOVES) and returns
+     * how many there are
+     */
+    int findMoves(Move* moves) const;
+
+    /**
+     * True if at least one swap produces a match
+     */
+    bool hasMove() const;
+
+    /**
+     * Picks one swap that produces a match; false on a dead board
+     */
+    bool findHint(Move& hint) const;
+
+    /**
+     * Shuffles the tiles already on the board (same species counts) into a
+     * layout without matches that has at least one move
+     */
+    void reshuffle();
+
+    /**
+     * Compacts every column with matched tiles in one pass: survivors fall
+     * to their final row (recording the distance) and holes collect on top
+     */
+    void applyGravity();
+
+    /**
+     * Fills the holes left by applyGravity() with new tiles dropping in
+     * from above
+     */
+    void refill();
+
+private:
+    int swapRow0, swapCol0, swapRow1, swapCol1; // Pending swap to revert
+    float tickAccumulator;                      // Frame time not yet ticked
+    float fadeTime;                             // Time spent fading the matches
+
+    void rebuildMasks();
+    static Bitboard tripleCells(Bitboard mask);
+    void markDirty(int row, int col);
+    void extractRuns(int species, Bitboard horizontalRuns, Bitboard verticalRuns);
+    void moveMasks(Bitboard& horizontalSwaps, Bitboard& verticalSwaps) const;
+    bool placeShuffled(int* pool, int poolSize);
+    static int safeSpecies(const Bitboard* masks, Bitboard bit, const int* counts, int maxPerSpecies, int* choices);
+
+    bool stepAnimation();
+    bool fadeMatched();
+    void updateCombo(int currentMatchPoints);
+};
+
+// Sizes compiled into board.cpp; other sizes need their own instantiation
+extern template struct TileMotion<8 * 8>;
+extern template struct TileMotion<9 * 9>;
+extern template struct TileMotion<10 * 10>;
+extern template struct TileMotion<10 * 8>;
+extern template class BasicBoard<8, 8, SPECIES_COUNT>;
+extern template class BasicBoard<8, 8, 5>;
+extern template class BasicBoard<8, 8, 6>;
+extern template class BasicBoard<9, 9, SPECIES_COUNT>;
+extern template class BasicBoard<10, 10, SPECIES_COUNT>;
+extern template class BasicBoard<10, 8, SPECIES_COUNT>;
+
+// The game's board and its derived types
+typedef BasicBoard<BOARD_SIZE, BOARD_SIZE, SPECIES_COUNT> Board;
+typedef Board::PackedBoard PackedBoard;
+
+const int CELL_COUNT = Board::CELLS;
+
+#endif
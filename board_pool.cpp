@@ -0,0 +1,64 @@
+#include "board_pool.h"
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+BoardPool::BoardPool(int capacity) : capacity(capacity), stopping(false), worker(&BoardPool::run, this) {}
+
+BoardPool::~BoardPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wanted.notify_one();
+    worker.join();
+}
+
+uint64_t BoardPool::take(Board& board) {
+    unique_lock<mutex> guard(lock);
+    if (ready.empty()) {
+        guard.unlock();
+        uint64_t seed = nextSeed();
+        board.newGame(seed);
+        return seed;
+    }
+
+    uint64_t seed = ready.front().seed;
+    board = ready.front().board;
+    ready.pop_front();
+    guard.unlock();
+    wanted.notify_one();
+    return seed;
+}
+
+/**
+ * Seed of a new game: the clock, told apart from other games made in the
+ * same tick by a counter
+ */
+uint64_t BoardPool::nextSeed() {
+    static atomic<uint64_t> counter(0);
+    uint64_t seed = chrono::system_clock::now().time_since_epoch().count();
+    return seed + (counter++ << 48);
+}
+
+/**
+ * Tops the pool up to capacity whenever a game is taken. Boards are built
+ * outside the lock, so take() never waits for one.
+ */
+void BoardPool::run() {
+    unique_lock<mutex> guard(lock);
+    while (!stopping) {
+        if (int(ready.size()) >= capacity) {
+            wanted.wait(guard);
+            continue;
+        }
+
+        guard.unlock();
+        ReadyGame game;
+        game.seed = nextSeed();
+        game.board.newGame(game.seed);
+        guard.lock();
+        ready.push_back(game);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef MENAGERIE_BOARD_POOL_H
+#define MENAGERIE_BOARD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "board.h"
+
+// New games made ahead of time. A background thread keeps a few boards
+// ready, each exactly what Board::newGame(seed) builds for its seed, so a
+// level start or reset only copies one out and a replay of the game still
+// starts from the same board. take() never waits on the worker: with the
+// pool empty it builds the game itself.
+
+const int BOARD_POOL_SIZE = 4;      // Games kept ready
+
+class BoardPool {
+public:
+    explicit BoardPool(int capacity = BOARD_POOL_SIZE);
+    ~BoardPool();
+
+    BoardPool(const BoardPool&) = delete;
+    BoardPool& operator=(const BoardPool&) = delete;
+
+    /**
+     * Puts a ready game on the board and returns its seed. If the pool ran
+     * dry, the game is made on the spot.
+     */
+    uint64_t take(Board& board);
+
+private:
+    // A game made by newGame(seed)
+    struct ReadyGame {
+        uint64_t seed;
+        Board board;
+    };
+
+    int capacity;
+    std::deque<ReadyGame> ready;
+    std::mutex lock;
+    std::condition_variable wanted;     // A game was taken, or the pool stops
+    bool stopping;
+    std::thread worker;                 // Last, so it starts after the rest
+
+    static uint64_t nextSeed();
+    void run();
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "board_renderer.h"
+
+BoardRenderer::BoardRenderer(const sf::Texture& texture, sf::Vector2i sheet, sf::Vector2i boardOffset)
+    : texture(texture),
+      sheet(sheet),
+      origin(boardOffset.x - TILE_SIZE, boardOffset.y - TILE_SIZE),
+      vertices(sf::Quads, CELL_COUNT * 4) {
+    invalidate();
+}
+
+void BoardRenderer::invalidate() {
+    for (int cell = 0; cell < CELL_COUNT; cell++)
+        drawn[cell] = DrawnTile{0, 0, -1, 0};
+}
+
+bool BoardRenderer::update(const Board& board, std::vector<sf::FloatRect>& dirty) {
+    float blend = board.interpolation();
+    bool changed = false;
+    const Board::Motion& motion = board.motion;
+
+    for (int cell = 0; cell < CELL_COUNT; cell++) {
+        DrawnTile next;
+        next.x = motion.prevX[cell] + (motion.x[cell] - motion.prevX[cell]) * blend;
+        next.y = motion.prevY[cell] + (motion.y[cell] - motion.prevY[cell]) * blend;
+        next.species = board.species[cell] == EMPTY_CELL ? -1 : board.species[cell];
+        next.alpha = motion.prevAlpha[cell] + int((motion.alpha[cell] - motion.prevAlpha[cell]) * blend);
+
+        DrawnTile& last = drawn[cell];
+        if (next.x == last.x && next.y == last.y &&
+            next.species == last.species && next.alpha == last.alpha)
+            continue;
+
+        // Both where the tile was and where it is now need compositing
+        if (last.species >= 0 && last.alpha > 0)
+            dirty.push_back(tileRect(last));
+        if (next.species >= 0 && next.alpha > 0)
+            dirty.push_back(tileRect(next));
+
+        writeQuad(cell, next);
+        last = next;
+        changed = true;
+    }
+    return changed;
+}
+
+/**
+ * Writes the four corners of one tile: position, texture rect and alpha.
+ * An empty cell gets a zero-size transparent quad, so nothing is drawn.
+ */
+void BoardRenderer::writeQuad(int index, const DrawnTile& tile) {
+    sf::Vertex* quad = &vertices[index * 4];
+
+    if (tile.species < 0) {
+        for (int corner = 0; corner < 4; corner++) {
+            quad[corner].position = sf::Vector2f(origin);
+            quad[corner].texCoords = sf::Vector2f(sheet);
+            quad[corner].color = sf::Color::Transparent;
+        }
+        return;
+    }
+
+    float left = origin.x + tile.x;
+    float top = origin.y + tile.y;
+    float right = left + TILE_TEXTURE_SIZE;
+    float bottom = top + TILE_TEXTURE_SIZE;
+
+    float texLeft = float(sheet.x + tile.species * TILE_TEXTURE_SIZE);
+    float texRight = texLeft + TILE_TEXTURE_SIZE;
+    float texTop = float(sheet.y);
+    float texBottom = texTop + TILE_TEXTURE_SIZE;
+
+    sf::Color color(255, 255, 255, sf::Uint8(tile.alpha));
+
+    quad[0].position = sf::Vector2f(left, top);
+    quad[1].position = sf::Vector2f(right, top);
+    quad[2].position = sf::Vector2f(right, bottom);
+    quad[3].position = sf::Vector2f(left, bottom);
+
+    quad[0].texCoords = sf::Vector2f(texLeft, texTop);
+    quad[1].texCoords = sf::Vector2f(texRight, texTop);
+    quad[2].texCoords = sf::Vector2f(texRight, texBottom);
+    quad[3].texCoords = sf::Vector2f(texLeft, texBottom);
+
+    for (int corner = 0; corner < 4; corner++)
+        quad[corner].color = color;
+}
+
+/**
+ * Screen area a tile's quad covers
+ */
+sf::FloatRect BoardRenderer::tileRect(const DrawnTile& tile) const {
+    return sf::FloatRect(origin.x + tile.x, origin.y + tile.y, TILE_TEXTURE_SIZE, TILE_TEXTURE_SIZE);
+}
+
+void BoardRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    states.texture = &texture;
+    target.draw(vertices, states);
+}
@@ -0,0 +1,53 @@
+#ifndef MENAGERIE_BOARD_RENDERER_H
+#define MENAGERIE_BOARD_RENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "board.h"
+
+// Draws all 64 tiles as one quad vertex array against the animal texture.
+// Tiles are drawn between their previous and current tick positions, and
+// each quad is rewritten only when what it shows has changed.
+
+const int TILE_TEXTURE_SIZE = 49;   // Width/height of one animal in animals.png
+
+class BoardRenderer : public sf::Drawable {
+public:
+    /**
+     * sheet is where the row of animals starts in the texture
+     */
+    BoardRenderer(const sf::Texture& texture, sf::Vector2i sheet, sf::Vector2i boardOffset);
+
+    /**
+     * Brings the vertex array in line with the board, blending each tile
+     * between its last two ticks by the board's interpolation factor.
+     * Returns true if any tile looks different from the last update; the
+     * screen areas such tiles covered before and cover now go into dirty.
+     */
+    bool update(const Board& board, std::vector<sf::FloatRect>& dirty);
+
+    /**
+     * Forces every quad to be rewritten on the next update()
+     */
+    void invalidate();
+
+private:
+    // What each quad currently shows
+    struct DrawnTile {
+        float x, y;
+        int species;
+        int alpha;
+    };
+
+    const sf::Texture& texture;
+    sf::Vector2i sheet;                     // Texture position of the first animal
+    sf::Vector2i origin;                    // Screen position of grid cell (0, 0)
+    sf::VertexArray vertices;
+    DrawnTile drawn[CELL_COUNT];
+
+    void writeQuad(int index, const DrawnTile& tile);
+    sf::FloatRect tileRect(const DrawnTile& tile) const;
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif
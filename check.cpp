@@ -0,0 +1,141 @@
+#include "board.h"
+#include "replay.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Regression checks for the headless engine. Prints a line per failed
+// expectation and exits non-zero if any failed.
+//
+// Usage: check
+
+static int failures = 0;
+
+static void expect(bool condition, const string& what) {
+    if (condition)
+        return;
+    cout << "FAILED: " << what << "\n";
+    failures++;
+}
+
+/**
+ * Writes a replay file by hand: header, the given swap codes one tick
+ * apart, then the end marker
+ */
+static bool writeReplay(const string& path, const vector<int>& codes) {
+    ofstream out(path, ios::binary);
+    out.write("MRPL", 4);
+    out.put(char(2));                       // Format version
+    for (int i = 0; i < 8; i++)
+        out.put(char(i == 0 ? 7 : 0));      // Seed 7
+    for (int code : codes) {
+        out.put(char(1));
+        out.put(char(code));
+    }
+    out.put(char(1));
+    out.put(char(0xFF));
+    for (int i = 0; i < 4; i++)
+        out.put(char(0));
+    return bool(out);
+}
+
+/**
+ * Replays whose swaps would leave the board are rejected on load
+ */
+static void checkReplayBounds() {
+    const string path = "check-replay.mrp";
+    const int last = BOARD_SIZE - 1;
+    struct Case {
+        int code;
+        bool valid;
+        const char* name;
+    } cases[] = {
+        {0, true, "right from the first cell"},
+        {0x40, true, "down from the first cell"},
+        {last, false, "right from the last column"},
+        {last | 0x40, true, "down from the last column"},
+        {last * BOARD_SIZE, true, "right from the last row"},
+        {last * BOARD_SIZE | 0x40, false, "down from the last row"},
+        {BOARD_SIZE * BOARD_SIZE - 1, false, "right from the last cell"},
+        {0x80, false, "cell past the board"},
+    };
+
+    for (const Case& c : cases) {
+        Replay replay;
+        expect(writeReplay(path, {c.code}), "writing " + path);
+        expect(replay.load(path) == c.valid, string("replay swap ") + c.name +
+               (c.valid ? " loads" : " is rejected"));
+    }
+    remove(path.c_str());
+}
+
+/**
+ * On a board wider than it is tall, a match in the last column is found
+ * after the masks are rebuilt
+ */
+static void checkLastColumnMatch() {
+    typedef BasicBoard<10, 8, SPECIES_COUNT> WideBoard;
+    int layout[WideBoard::HEIGHT][WideBoard::WIDTH];
+    for (int row = 0; row < WideBoard::HEIGHT; row++)
+        for (int col = 0; col < WideBoard::WIDTH; col++)
+            layout[row][col] = (row + col) % WideBoard::SPECIES;   // Diagonals, no match
+    for (int row = 0; row < 3; row++)
+        layout[row][WideBoard::WIDTH - 1] = 0;
+
+    WideBoard board;
+    board.setLayout(layout);
+    WideBoard::Bitboard matches = board.findMatches();
+    for (int row = 1; row <= 3; row++)
+        expect(matches & WideBoard::cellBit(row, WideBoard::WIDTH),
+               "10x8 match in the last column, row " + to_string(row));
+    expect(!(matches & ~WideBoard::FULL), "10x8 matches stay on the board");
+}
+
+/**
+ * Once a board has played out its animations and gone idle, every tile
+ * renders on its grid cell whatever the interpolation
+ */
+static void checkSettledTiles() {
+    Board board;
+    board.newGame(7);
+    Move moves[Board::MAX_MOVES];
+    int settled = 0;
+    for (int swap = 0; swap < 50; swap++) {
+        int count = board.findMoves(moves);
+        if (!count)
+            break;
+        const Move& move = moves[swap % count];
+        board.beginSwap(move.row0, move.col0, move.row1, move.col1);
+        cout.setstate(ios::failbit);    // Hush the board's combo messages
+        for (int tick = 0; tick < 10000 && !board.isIdle(); tick++)
+            board.update();
+        cout.clear();
+
+        for (int cell = 0; cell < Board::CELLS; cell++) {
+            if (board.motion.prevX[cell] != board.motion.x[cell] ||
+                board.motion.prevY[cell] != board.motion.y[cell]) {
+                expect(false, "tile " + to_string(cell) + " settled off-grid after swap " + to_string(swap));
+                return;
+            }
+        }
+        settled++;
+    }
+    expect(settled > 0, "settled boards to check");
+}
+
+int main() {
+    checkReplayBounds();
+    checkLastColumnMatch();
+    checkSettledTiles();
+
+    if (failures) {
+        cout << failures << " check(s) failed\n";
+        return 1;
+    }
+    cout << "All checks passed\n";
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "compositor.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+Compositor::Compositor() {
+    fullRedraw = true;
+}
+
+bool Compositor::create(unsigned width, unsigned height) {
+    size = sf::Vector2f(float(width), float(height));
+    fullRedraw = true;
+    return background.create(width, height) && frame.create(width, height);
+}
+
+sf::RenderTexture& Compositor::staticLayer() {
+    return background;
+}
+
+void Compositor::commitStatic() {
+    background.display();
+    fullRedraw = true;
+}
+
+void Compositor::invalidate(vector<sf::FloatRect>& rects) {
+    for (const sf::FloatRect& rect : rects) {
+        // Whole pixels, one more on each side for antialiased edges
+        int left = max(int(floor(rect.left)) - 1, 0);
+        int top = max(int(floor(rect.top)) - 1, 0);
+        int right = min(int(ceil(rect.left + rect.width)) + 1, int(size.x));
+        int bottom = min(int(ceil(rect.top + rect.height)) + 1, int(size.y));
+        if (left < right && top < bottom)
+            dirty.push_back(sf::IntRect(left, top, right - left, bottom - top));
+    }
+    rects.clear();
+}
+
+bool Compositor::compose(initializer_list<const sf::Drawable*> layers) {
+    if (fullRedraw) {
+        dirty.assign(1, sf::IntRect(0, 0, int(size.x), int(size.y)));
+        fullRedraw = false;
+    } else {
+        mergeDirty();
+    }
+    if (dirty.empty())
+        return false;
+
+    sf::Sprite staticSprite(background.getTexture());
+    for (const sf::IntRect& rect : dirty) {
+        // A view of just the rectangle, shown in the same place, clips
+        // everything drawn through it to the rectangle
+        sf::View view(sf::FloatRect(float(rect.left), float(rect.top), float(rect.width), float(rect.height)));
+        view.setViewport(sf::FloatRect(rect.left / size.x, rect.top / size.y, rect.width / size.x, rect.height / size.y));
+        frame.setView(view);
+
+        frame.draw(staticSprite);
+        for (const sf::Drawable* layer : layers)
+            frame.draw(*layer);
+    }
+    frame.setView(frame.getDefaultView());
+    frame.display();
+    dirty.clear();
+    return true;
+}
+
+/**
+ * Joins overlapping rectangles so no pixel is composited twice. If the dirty
+ * area covers most of the frame, the whole frame is redone in one pass.
+ */
+void Compositor::mergeDirty() {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < dirty.size(); i++) {
+            for (size_t j = i + 1; j < dirty.size(); j++) {
+                sf::IntRect& a = dirty[i];
+                const sf::IntRect& b = dirty[j];
+                if (!a.intersects(b))
+                    continue;
+
+                int left = min(a.left, b.left), top = min(a.top, b.top);
+                int right = max(a.left + a.width, b.left + b.width);
+                int bottom = max(a.top + a.height, b.top + b.height);
+                a = sf::IntRect(left, top, right - left, bottom - top);
+                dirty[j] = dirty.back();
+                dirty.pop_back();
+                merged = true;
+                j--;
+            }
+        }
+    }
+
+    float area = 0;
+    for (const sf::IntRect& rect : dirty)
+        area += float(rect.width) * rect.height;
+    if (area > COMPOSITE_FULL_FRACTION * size.x * size.y)
+        dirty.assign(1, sf::IntRect(0, 0, int(size.x), int(size.y)));
+}
+
+void Compositor::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    target.draw(sf::Sprite(frame.getTexture()), states);
+}
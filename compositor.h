@@ -0,0 +1,60 @@
+#ifndef MENAGERIE_COMPOSITOR_H
+#define MENAGERIE_COMPOSITOR_H
+
+#include <SFML/Graphics.hpp>
+#include <initializer_list>
+#include <vector>
+
+// Layered frame compositor. Content that never moves during a level (the
+// background and the HUD labels) is rendered once into a static layer. The
+// finished frame is kept in a second texture, and each frame only the
+// rectangles where something changed are restored from the static layer and
+// have the dynamic layers drawn over them, clipped to the rectangle. Drawing
+// the compositor puts the kept frame on screen in one textured quad.
+
+const float COMPOSITE_FULL_FRACTION = 0.6f; // Dirty area beyond which the whole frame is redone
+
+class Compositor : public sf::Drawable {
+public:
+    Compositor();
+
+    /**
+     * Creates the static layer and the frame texture; false if the render
+     * textures are not available
+     */
+    bool create(unsigned width, unsigned height);
+
+    /**
+     * Target for the static content: clear it, draw into it, then call
+     * commitStatic()
+     */
+    sf::RenderTexture& staticLayer();
+
+    /**
+     * Finishes the static layer and schedules the whole frame to be redone
+     */
+    void commitStatic();
+
+    /**
+     * Marks screen areas whose content changed and empties the list
+     */
+    void invalidate(std::vector<sf::FloatRect>& rects);
+
+    /**
+     * Re-composites the dirty rectangles from the static layer and the
+     * given layers (drawn in order). Returns true if the frame changed.
+     */
+    bool compose(std::initializer_list<const sf::Drawable*> layers);
+
+private:
+    sf::RenderTexture background;   // Static layer
+    sf::RenderTexture frame;        // Last composited frame
+    sf::Vector2f size;
+    std::vector<sf::IntRect> dirty;
+    bool fullRedraw;
+
+    void mergeDirty();
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif
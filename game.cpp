@@ -1,213 +1,467 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
-#include <time.h>
+#include "asset_archive.h"
+#include "asset_loader.h"
+#include "board.h"
+#include "board_pool.h"
+#include "board_renderer.h"
+#include "compositor.h"
+#include "hud.h"
+#include "latency_histogram.h"
+#include "profiler_overlay.h"
+#include "replay.h"
+#include "solver.h"
+#include "sound_pool.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 using namespace sf;
 using namespace std;
 
 // Sound effects and music
 sf::SoundBuffer matchBuffer;
-sf::Sound match;
-
 sf::SoundBuffer clickBuffer;
-sf::Sound click;
-
 sf::SoundBuffer gameoverBuffer;
-sf::Sound gameover;
+SoundPool sounds;           // Effects are triggered here and started once per frame
 
 sf::Music backgroundMusic;
 
 // Game constants
-const int TILE_SIZE = 54;
 Vector2i boardOffset(48, 24);
+const int FRAME_RATE_LIMIT = 60; // Render rate only; logic runs at TICK_RATE
 
 // Game state variables
-int totalScore = 0;
-int comboCount = 0;
-int maxCombo = 0;
-bool hasGameStarted = false;
 bool gameOverSoundPlayed = false;
 bool clockStarted = false;
 int previousGameState = 0; // 1 for level1, 2 for level2
 
-// Tile structure representing each game tile
-struct Tile {
-    int x, y;           // Screen position
-    int col, row;       // Grid position
-    int species;        // Type of animal
-    int matched;        // Whether tile is matched
-    int alpha;          // Transparency for animations
-
-    Tile() {
-        matched = 0;
-        alpha = 255;
-    }
-} grid[10][10]; // 10x10 grid (with borders)
+// Game board (tiles, score and combo state)
+Board board;
+BoardPool boardPool;        // New games made ahead on a background thread
+uint64_t boardSeed = 0;     // Seed of the game in board
+bool boardDealt = false;    // board holds a game nobody has played yet
+
+// Session recording of the level being played
+Replay replay;
+bool recording = false;
+
+// Background lookahead for hints and autoplay
+Solver solver;
+bool searching = false;     // The solver is working on the current idle board
+bool autoplay = false;
+const float AUTOPLAY_THINK_SECONDS = 0.5f;  // Search time before autoplay swaps
+
+// First tile of a swap being picked with the mouse (row 0 = none)
+int selectedRow = 0, selectedCol = 0;
+
+// Simulation/render split: a logic thread runs the game and publishes what
+// is on screen as snapshots through a triple buffer; the main thread owns
+// the window, forwards input through a queue and draws the newest snapshot
+struct GameSnapshot {
+    int gameState;              // Screen to show
+    Board board;                // Tiles, with their motion for interpolation
+    int remainingMoves;         // Level 1 HUD
+    int timeLeft;               // Level 2 HUD
+    bool showHint;
+    Move hintMove;
+    bool idle;                  // Nothing changes until the next input
+    uint32_t inputSeen;         // Input events the logic had taken by then
+
+    // Latency probe: the newest swap started by a click
+    uint32_t clickSwaps;        // Swaps started by clicks so far
+    chrono::steady_clock::time_point swapClicked, swapStarted;
+};
+
+// An input event and when the window took it
+struct InputEvent {
+    Event event;
+    chrono::steady_clock::time_point received;
+};
+
+const uint32_t INPUT_QUEUE_SIZE = 256;
+
+TripleBuffer<GameSnapshot> snapshots;
+SpscQueue<InputEvent, INPUT_QUEUE_SIZE> input;
+uint32_t inputSent = 0;             // Main thread: events forwarded
+uint32_t inputTaken = 0;            // Logic thread: events taken
+mutex inputLock;                    // Only for sleeping until input arrives
+condition_variable inputArrived;
+atomic<bool> quitLogic(false);
+
+// The main thread's own profiler; the global one follows the logic steps
+Profiler renderProfiler;
+
+// Input latency of click swaps, measured on the main thread and printed on
+// exit: click to swap start, swap start to the first frame shown with it,
+// and the whole way
+LatencyHistogram clickToSwap, swapToPresent, clickToPresent;
+
+// Idle-aware rendering: a frame is drawn only when something on screen
+// changed, and a screen with nothing left to animate sleeps in waitEvent()
+bool redrawNeeded = true;   // The next frame must be drawn
+bool waitForEvent = false;  // Block until the next event instead of polling
+
+// Startup: assets come from assets.pak and the start screen is shown as soon
+// as the critical ones are decoded; the rest finish in the background
+chrono::steady_clock::time_point launchTime;
+bool firstFrameShown = false;
 
 /**
- * Swaps two tiles on the game board
+ * Milliseconds since the game was launched
  */
-void swapTiles(Tile tile1, Tile tile2) {
-    swap(tile1.col, tile2.col);
-    swap(tile1.row, tile2.row);
+long long millisecondsSinceLaunch() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - launchTime).count();
+}
 
-    grid[tile1.row][tile1.col] = tile1;
-    grid[tile2.row][tile2.col] = tile2;
+/**
+ * Loader task decoding one archive member with the asset's loadFromMemory()
+ */
+template<typename Asset>
+function<bool()> decodeTask(const AssetArchive& assets, const string& name, Asset& asset) {
+    return [&assets, name, &asset] {
+        size_t size;
+        const void* data = assets.data(name, size);
+        return data && asset.loadFromMemory(data, size);
+    };
 }
 
 /**
- * Handles tile gravity and combo calculations
+ * Sprite showing one packed image of the atlas
  */
-void applyGravity(bool isMoving, int currentMatchPoints, bool isSwap) {
-    if (!isMoving) {
-        // Make matched tiles fall down
-        for (int row = 8; row > 0; row--) {
-            for (int col = 1; col <= 8; col++) {
-                if (grid[row][col].matched) {
-                    int targetRow = row;
-                    while (targetRow > 0) {
-                        if (!grid[targetRow][col].matched) {
-                            swapTiles(grid[targetRow][col], grid[row][col]);
-                            break;
-                        }
-                        targetRow--;
-                    }
-                }
-            }
-        }
+Sprite atlasSprite(const Texture& atlas, const AssetEntry& region) {
+    return Sprite(atlas, IntRect(region.x, region.y, region.width, region.height));
+}
 
-        // Combo handling
-        if (currentMatchPoints > 0) {
-            comboCount++;
-            maxCombo = max(maxCombo, comboCount);
-        } else if (!isMoving && !isSwap) {
-            if (comboCount > 1)
-                cout << "Combo x" << comboCount << "!\n";
-            comboCount = 0;
-        }
+/**
+ * Puts a ready game from the pool on the board without playing it; the next
+ * level starts on it
+ */
+void dealBoard() {
+    boardSeed = boardPool.take(board);
+    boardDealt = true;
+}
+
+/**
+ * Starts a level on the dealt board, or on a fresh one if that was already
+ * played, and starts recording it
+ */
+void startLevel() {
+    if (!boardDealt)
+        dealBoard();
+    boardDealt = false;
+    selectedRow = selectedCol = 0;
+    replay.begin(boardSeed);
+    recording = true;
+    solver.cancel();
+    searching = false;
+}
+
+/**
+ * Closes the current recording and writes it to replay-<seed>.mrp
+ */
+void saveReplay() {
+    if (!recording)
+        return;
+    recording = false;
+
+    replay.finish(board.tickCount, board.totalScore);
+    string path = "replay-" + to_string(replay.seed) + ".mrp";
+    if (!replay.save(path))
+        cout << "Failed to save " << path << "\n";
+}
+
+/**
+ * Applies a click on the board the moment it is taken from the queue: the
+ * first click selects a tile, a click on a neighbour of the selected tile
+ * swaps the two, and any other click selects anew. Clicks off the board or
+ * while tiles move are ignored. Returns true if a swap started.
+ */
+bool clickTile(int x, int y) {
+    if (board.isSwapping || board.isMoving)
+        return false;
+
+    Vector2i position = Vector2i(x, y) - boardOffset;
+    if (position.x < 0 || position.y < 0)
+        return false;
+    int col = position.x / TILE_SIZE + 1;
+    int row = position.y / TILE_SIZE + 1;
+    if (col > BOARD_SIZE || row > BOARD_SIZE)
+        return false;
+
+    // Only allow adjacent swaps
+    if (selectedRow != 0 && abs(row - selectedRow) + abs(col - selectedCol) == 1) {
+        replay.recordSwap(board.tickCount, Move{selectedRow, selectedCol, row, col});
+        board.beginSwap(selectedRow, selectedCol, row, col);
+        selectedRow = selectedCol = 0;
+        return true;
     }
+    selectedRow = row;
+    selectedCol = col;
+    return false;
 }
 
 /**
- * Clears initial matches when game starts
+ * Keeps the solver on the current board: a search starts whenever the
+ * board settles and is dropped as soon as it changes again
  */
-void clearInitialMatches() {
-    for (int row = 1; row <= 8; row++)
-        for (int col = 1; col <= 8; col++) {
-            int& sp = grid[row][col].species;
-            while ((sp == grid[row - 1][col].species && sp == grid[row - 2][col].species) ||
-                   (sp == grid[row][col - 1].species && sp == grid[row][col - 2].species)) {
-                sp = rand() % 7;
-            }
-        }
+void updateSolver() {
+    if (!board.isIdle()) {
+        if (searching)
+            solver.cancel();
+        searching = false;
+    } else if (!searching) {
+        solver.start(board);
+        searching = true;
+    }
 }
 
-int main() {
-    // Game state management
-    int gameState = 0; // 0=start, 1=level1, 2=level2, 3=pause, 4=gameover, 5=reset, 6=level2intro
-    int levelTime = 30;
-    srand(time(0));
+/**
+ * Best swap known right now: the solver's best so far, or any valid swap
+ * while the solver has nothing yet
+ */
+bool suggestMove(Move& move) {
+    return (searching && solver.best(move)) || board.findHint(move);
+}
 
-    // Window setup
-    RenderWindow window(VideoMode(790, 475), "MENAGERIE");
-    window.setFramerateLimit(60);
+/**
+ * The swap autoplay makes this step, once the solver has had its time
+ */
+bool autoplayMove(Move& move) {
+    if (!autoplay || !searching)
+        return false;
+    if (!solver.isDone() && solver.searchSeconds() < AUTOPLAY_THINK_SECONDS)
+        return false;
+    return suggestMove(move);
+}
 
-    // Font setup
-    Font gameFont;
-    gameFont.loadFromFile("fonts/hello.ttf");
+/**
+ * Next event of this frame. When the screen is idle the first call blocks
+ * until an event arrives; the time asleep does not count as frame time.
+ * Any event other than mouse movement marks the screen for redrawing.
+ */
+bool nextEvent(RenderWindow& window, Event& event, Clock& frameClock) {
+    bool received;
+    if (waitForEvent) {
+        waitForEvent = false;
+        received = window.waitEvent(event);
+        frameClock.restart();
+    } else {
+        received = window.pollEvent(event);
+    }
 
-    // UI Text elements
-    Text moveText, moveLabel;
-    moveText.setFont(gameFont);
-    moveText.setCharacterSize(30);
-    moveText.setFillColor(Color::Yellow);
-    moveText.setPosition(600, 160);
-    moveText.setStyle(Text::Bold);
-
-    moveLabel.setFont(gameFont);
-    moveLabel.setCharacterSize(30);
-    moveLabel.setFillColor(Color::Yellow);
-    moveLabel.setPosition(500, 160);
-    moveLabel.setStyle(Text::Bold);
-
-    // Texture loading
-    Texture texBackground, texAnimals, texStart, texPause, textLevel2, texRestart;
-    texBackground.loadFromFile("sprites/background.png");
-    texAnimals.loadFromFile("sprites/animals.png");
-    texStart.loadFromFile("sprites/start.png");
-    texPause.loadFromFile("sprites/pause.png");
-    texRestart.loadFromFile("sprites/restart.png");
-    textLevel2.loadFromFile("sprites/level2.png");
-
-    // Sprite setup
-    Sprite background(texBackground), animalSprites(texAnimals), 
-           startScreen(texStart), pauseScreen(texPause), 
-           level2Screen(textLevel2), restartScreen(texRestart);
-
-    // Sound setup
-    if (!matchBuffer.loadFromFile("sounds/match.wav"))
-        cout << "Failed to load match.wav\n";
-    match.setBuffer(matchBuffer);
-
-    if (!clickBuffer.loadFromFile("sounds/click.wav"))
-        cout << "Failed to load click.wav\n";
-    click.setBuffer(clickBuffer);
-    
-    if (!gameoverBuffer.loadFromFile("sounds/gameover.wav"))
-        cout << "Failed to load gameover.wav\n";
-    gameover.setBuffer(gameoverBuffer);
-    
-    if (!backgroundMusic.openFromFile("sounds/Rainbows.wav")) {
-        cout << "Error loading background music!" << endl;
+    if (received && event.type != Event::MouseMoved)
+        redrawNeeded = true;
+    return received;
+}
+
+/**
+ * Hands an input event to the logic thread, stamped with the time it was
+ * taken from the window, and wakes the logic thread if it sleeps
+ */
+void sendInput(const Event& event) {
+    InputEvent stamped = {event, chrono::steady_clock::now()};
+    while (!input.push(stamped))
+        this_thread::yield();   // Full: the logic thread drains it every step
+    inputSent++;
+
+    lock_guard<mutex> guard(inputLock);
+    inputArrived.notify_one();
+}
+
+/**
+ * Logic thread: next input event forwarded by the window
+ */
+bool nextInput(InputEvent& event) {
+    if (!input.pop(event))
+        return false;
+    inputTaken++;
+    return true;
+}
+
+/**
+ * Logic thread: sleeps until the next step is due, waking early for input.
+ * An idle game sleeps until input arrives.
+ */
+void waitForStep(const Clock& stepClock, bool idle) {
+    auto woken = [] { return !input.empty() || quitLogic; };
+    unique_lock<mutex> guard(inputLock);
+    if (idle) {
+        inputArrived.wait(guard, woken);
     } else {
-        backgroundMusic.setLoop(true);     // Loop the music
-        backgroundMusic.setVolume(50);     // Set volume (0-100)
-        backgroundMusic.play();           // Start playing
+        sf::Time left = sf::seconds(TICK_SECONDS) - stepClock.getElapsedTime();
+        if (left > sf::Time::Zero)
+            inputArrived.wait_for(guard, chrono::microseconds(left.asMicroseconds()), woken);
     }
+}
 
-    // Initialize game grid
-    for (int row = 1; row <= 8; row++) {
-        for (int col = 1; col <= 8; col++) {
-            grid[row][col].species = rand() % 7;
-            grid[row][col].col = col;
-            grid[row][col].row = row;
-            grid[row][col].x = col * TILE_SIZE;
-            grid[row][col].y = row * TILE_SIZE;
+/**
+ * Draws a full-screen still image if the screen needs drawing
+ */
+void drawStill(RenderWindow& window, const Sprite& screen) {
+    if (redrawNeeded) {
+        window.clear();
+        window.draw(screen);
+    }
+}
+
+/**
+ * Ends a frame: shows it if it was redrawn, otherwise sleeps out the frame,
+ * or waits for the next event if nothing can change without one
+ */
+void finishFrame(RenderWindow& window, const Clock& frameClock, bool canWait) {
+    if (redrawNeeded) {
+        window.display();
+        redrawNeeded = false;
+
+        if (!firstFrameShown) {
+            firstFrameShown = true;
+            cout << "Time to first frame: " << millisecondsSinceLaunch() << " ms\n";
         }
+    } else if (canWait) {
+        waitForEvent = true;
+    } else {
+        sf::sleep(sf::seconds(1.0f / FRAME_RATE_LIMIT) - frameClock.getElapsedTime());
     }
-    clearInitialMatches();
+}
+
+/**
+ * Renders what stays put during a level into the static layer: the
+ * background and the HUD labels of the current mode
+ */
+void buildStaticLayer(Compositor& compositor, const Sprite& background, const Hud& hud) {
+    RenderTexture& layer = compositor.staticLayer();
+    layer.clear();
+    layer.draw(background);
+    hud.drawLabels(layer);
+    compositor.commitStatic();
+}
+
+/**
+ * Outlines the two tiles of a hinted swap
+ */
+void drawHint(RenderWindow& window, const Move& hint) {
+    RectangleShape outline(Vector2f(TILE_TEXTURE_SIZE, TILE_TEXTURE_SIZE));
+    outline.setFillColor(Color::Transparent);
+    outline.setOutlineColor(Color::Yellow);
+    outline.setOutlineThickness(3);
+
+    outline.setPosition(boardOffset.x + (hint.col0 - 1) * TILE_SIZE, boardOffset.y + (hint.row0 - 1) * TILE_SIZE);
+    window.draw(outline);
+    outline.setPosition(boardOffset.x + (hint.col1 - 1) * TILE_SIZE, boardOffset.y + (hint.row1 - 1) * TILE_SIZE);
+    window.draw(outline);
+}
+
+/**
+ * The game itself, on its own thread: takes the input the window forwards,
+ * runs the state machine, the board, the solver and the audio, and
+ * publishes a snapshot of the screen after every step
+ */
+void runLogic(AssetLoader& loader, const bool& musicOpened) {
+    // Game state management
+    int gameState = 0; // 0=start, 1=level1, 2=level2, 3=pause, 4=gameover, 5=reset, 6=level2intro
+    int levelTime = 30;
+    bool assetsLoading = true;  // Non-critical assets are still being decoded
+    bool musicReady = false;    // Music opened and safe to touch (set once loading is done)
+
+    // Initialize game grid; recording starts with the first level
+    dealBoard();
 
     // Gameplay variables
-    int selectedX0, selectedY0, selectedX, selectedY; // Tile selection positions
-    int clickCount = 0;                               // Mouse click counter
-    Vector2i mousePos;                                // Mouse position
-    bool isSwapping = false, isMoving = false;        // Animation states
-    int remainingMoves = 10;                          // Moves remaining
+    int remainingMoves = LEVEL1_MOVES;                // Moves remaining
+    int timeLeft = 0;                                 // Level 2 seconds remaining
+    Move hintMove;                                    // Swap suggested with H
+    bool showHint = false;
+
+    // Latency probe of the newest swap started by a click
+    uint32_t clickSwaps = 0;
+    chrono::steady_clock::time_point swapClicked, swapStarted;
+
+    // Bookkeeping shared by every swap, whoever started it
+    auto afterSwap = [&]() {
+        showHint = false;
+        remainingMoves--;
+        sounds.trigger(SOUND_CLICK);
+    };
+
+    // A click is applied the moment it is taken from the queue; a swap it
+    // starts is timed for the latency probe
+    auto handleClick = [&](const InputEvent& command) {
+        if (!clickTile(command.event.mouseButton.x, command.event.mouseButton.y))
+            return;
+        afterSwap();
+        clickSwaps++;
+        swapClicked = command.received;
+        swapStarted = chrono::steady_clock::now();
+    };
     
     // Time management
     sf::Clock clock;
     sf::Time pausedTime;         // When pause started
     sf::Time totalPausedTime;    // Accumulated paused duration
     bool isPaused = false;
-    const float timeLimit = 30.0f;
+    const float timeLimit = LEVEL2_SECONDS;
     
-    // Main game loop
-    while (window.isOpen()) {
-        window.clear();
+    // Logic loop: one step per board tick while anything is moving
+    sf::Clock stepClock;
+    bool stepped = false;
+    while (!quitLogic) {
+        // Publish what the last step produced and start its sounds, then
+        // sleep until the next step, or until input if nothing can change
+        // without it
+        if (stepped) {
+            sounds.flush();
+            bool idle = !assetsLoading &&
+                        (gameState == 0 || gameState == 3 || gameState == 4 || gameState == 6 ||
+                         (gameState == 1 && board.isIdle() && searching && !autoplay));
+
+            GameSnapshot& next = snapshots.writeBuffer();
+            next.gameState = gameState;
+            next.board = board;
+            next.remainingMoves = remainingMoves;
+            next.timeLeft = timeLeft;
+            next.showHint = showHint;
+            next.hintMove = hintMove;
+            next.idle = idle;
+            next.inputSeen = inputTaken;
+            next.clickSwaps = clickSwaps;
+            next.swapClicked = swapClicked;
+            next.swapStarted = swapStarted;
+            snapshots.publish();
+
+            waitForStep(stepClock, idle);
+            if (quitLogic)
+                break;
+        }
+        stepped = true;
+        float stepSeconds = stepClock.restart().asSeconds();
+        profiler.nextFrame();
+
+        // Non-critical assets finished decoding in the background
+        if (assetsLoading && loader.isDone()) {
+            assetsLoading = false;
+            sounds.setBuffer(SOUND_GAMEOVER, gameoverBuffer);
+            musicReady = musicOpened;
+            if (musicReady) {
+                backgroundMusic.setLoop(true);     // Loop the music
+                backgroundMusic.setVolume(50);     // Set volume (0-100)
+                backgroundMusic.play();           // Start playing
+            }
+            cout << "All assets loaded after " << millisecondsSinceLaunch() << " ms\n";
+        }
 
         // =============================================
         // Game State: 0 - Start Screen
         // =============================================
         if (gameState == 0) {
-            window.draw(startScreen);
-            window.display();
-
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-                    
+            InputEvent command;
+            while (nextInput(command)) {
+                const Event& event = command.event;
                 // Pause handling
                 if (event.type == Event::KeyPressed && event.key.code == Keyboard::P) {
                     if (gameState == 1 || gameState == 2) {
@@ -222,11 +476,12 @@ int main() {
                 if (event.type == Event::KeyPressed) {
                     if (event.key.code == Keyboard::S) {
                         gameState = 1; // Start level 1
-                        match.play();
+                        startLevel();
+                        sounds.trigger(SOUND_MATCH);
                     }
                     if (event.key.code == Keyboard::E) {
                         gameState = 2; // Start level 2
-                        clearInitialMatches();
+                        startLevel();
                     }
                 }
             }
@@ -236,430 +491,143 @@ int main() {
         // Game State: 1 - Level 1 (Move-based)
         // =============================================
         else if (gameState == 1) {
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-                    
-                // Tile selection
-                else if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left) {
-                    if (!isSwapping && !isMoving)
-                        clickCount++;
-                    mousePos = Mouse::getPosition(window) - boardOffset;
-                } 
+            ProfileScope events(PHASE_EVENTS);
+            InputEvent command;
+            while (nextInput(command)) {
+                const Event& event = command.event;
+                // Tile selection, handled as it arrives
+                if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left)
+                    handleClick(command);
                 // Keyboard controls
                 else if (event.type == Event::KeyPressed) {
                     if (event.key.code == Keyboard::P) gameState = 3; // Pause
+                    if (event.key.code == Keyboard::H) showHint = suggestMove(hintMove); // Hint
+                    if (event.key.code == Keyboard::A) autoplay = !autoplay; // Autoplay
                     if (event.key.code == Keyboard::X) {
+                        saveReplay();
                         gameState = 5; // Reset game
-                        totalScore = 0;
-                        hasGameStarted = false;
-                        clearInitialMatches();
+                        board.totalScore = 0;
+                        board.hasGameStarted = false;
                     }
                 }
             }
+            events.stop();
 
-            // Update move counter display
-            moveText.setString(to_string(remainingMoves));
-            moveLabel.setString("Moves: ");
-            
             // Check if moves are exhausted
             if (remainingMoves <= 0) {
+                saveReplay();
                 gameState = 6; // Transition to level 2 intro
+                sounds.trigger(SOUND_GAMEOVER);
                 clock.restart();
                 clockStarted = true;
                 continue; 
             }
 
-            // Handle tile selection and swapping
-            if (clickCount == 1) {
-                selectedX0 = mousePos.x / TILE_SIZE + 1;
-                selectedY0 = mousePos.y / TILE_SIZE + 1;
-            } 
-            else if (clickCount == 2) {
-                selectedX = mousePos.x / TILE_SIZE + 1;
-                selectedY = mousePos.y / TILE_SIZE + 1;
-
-                // Only allow adjacent swaps
-                if (abs(selectedX - selectedX0) + abs(selectedY - selectedY0) == 1) {
-                    swapTiles(grid[selectedY0][selectedX0], grid[selectedY][selectedX]);
-                    isSwapping = true;
-                    clickCount = 0;
-                    remainingMoves--;
-                    hasGameStarted = true;
-                    click.play();
-                } else {
-                    clickCount = 1;
-                }
-            }
-
-            // Check for matches
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    // Vertical matches
-                    if (grid[row][col].species == grid[row + 1][col].species &&
-                        grid[row][col].species == grid[row - 1][col].species) {
-                        for (int offset = -1; offset <= 1; offset++) {
-                            grid[row + offset][col].matched++;
-                        }
-                    }
-                    
-                    // Horizontal matches
-                    if (grid[row][col].species == grid[row][col + 1].species &&
-                        grid[row][col].species == grid[row][col - 1].species) {
-                        for (int offset = -1; offset <= 1; offset++) {
-                            grid[row][col + offset].matched++;
-                        }
-                    }
-                }
-            }
-
-            // Tile movement animation
-            isMoving = false;
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    Tile& tile = grid[row][col];
-                    int dx, dy;
-                    
-                    // Smooth movement
-                    for (int step = 0; step < 10; step++) {
-                        dx = tile.x - tile.col * TILE_SIZE;
-                        dy = tile.y - tile.row * TILE_SIZE;
-                        if (dx) tile.x -= dx / abs(dx);
-                        if (dy) tile.y -= dy / abs(dy);
-                    }
-                    if (dx || dy) isMoving = true;
-                }
-            }
-
-            // Fade out matched tiles
-            if (!isMoving) {
-                for (int row = 1; row <= 8; row++) {
-                    for (int col = 1; col <= 8; col++) {
-                        if (grid[row][col].matched && grid[row][col].alpha > 10) {
-                            grid[row][col].alpha -= 10;
-                            isMoving = true;
-                        }
-                    }
-                }
-            }
-
-            // Calculate current match points
-            int currentMatchPoints = 0;
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    currentMatchPoints += grid[row][col].matched;
-                }
-            }
-
-            // Play match sound if needed
-            if (currentMatchPoints > 0) {
-                if (match.getStatus() != sf::Sound::Playing) {
-                    match.play();
-                }
-            }
-
-            // Update score
-            if (hasGameStarted) {
-                totalScore += currentMatchPoints;
+            ProfileScope selection(PHASE_SELECTION);
+            // Autoplay takes over the swap once the board has settled
+            updateSolver();
+            Move autoMove;
+            if (autoplayMove(autoMove)) {
+                replay.recordSwap(board.tickCount, autoMove);
+                board.beginSwap(autoMove.row0, autoMove.col0, autoMove.row1, autoMove.col1);
+                selectedRow = selectedCol = 0;
+                afterSwap();
             }
+            selection.stop();
 
-            // Handle invalid swaps
-            if (isSwapping && !isMoving) {
-                if (!currentMatchPoints) {
-                    swapTiles(grid[selectedY0][selectedX0], grid[selectedY][selectedX]);
-                }
-                isSwapping = false;
-            }
+            // Run the board logic ticks due this frame (matching, animation, scoring, refill)
+            int currentMatchPoints = board.advance(stepSeconds);
 
-            // Apply gravity to tiles
-            applyGravity(isMoving, currentMatchPoints, isSwapping);
-
-            // Replace matched tiles with new ones
-            for (int col = 1; col <= 8; col++) {
-                for (int row = 8, dropCount = 0; row > 0; row--) {
-                    if (grid[row][col].matched) {
-                        grid[row][col].species = rand() % 7;
-                        grid[row][col].y = -TILE_SIZE * dropCount++;
-                        grid[row][col].matched = 0;
-                        grid[row][col].alpha = 255;
-                    }
-                }
-            }
-
-            // Draw game elements
-            window.draw(background);
-
-            // Draw tiles
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    Tile tile = grid[row][col];
-                    animalSprites.setTextureRect(IntRect(tile.species * 49, 0, 49, 49));
-                    animalSprites.setColor(Color(255, 255, 255, tile.alpha));
-                    animalSprites.setPosition(tile.x, tile.y);
-                    animalSprites.move(boardOffset.x - TILE_SIZE, boardOffset.y - TILE_SIZE);
-                    window.draw(animalSprites);
-                }
-            }
-
-            // Draw UI elements
-            Text scoreText, scoreLabel;
-
-            scoreText.setFont(gameFont);
-            scoreText.setCharacterSize(27);
-            scoreText.setString(to_string(totalScore));
-            scoreText.setFillColor(Color::Yellow);
-            scoreText.setPosition(600, 190);
-            scoreText.setStyle(Text::Bold);
-
-            scoreLabel.setFont(gameFont);
-            scoreLabel.setCharacterSize(27);
-            scoreLabel.setString("Score: ");
-            scoreLabel.setFillColor(Color::Yellow);
-            scoreLabel.setPosition(500, 190);
-            scoreText.setStyle(Text::Bold);
-
-            window.draw(moveText);
-            window.draw(moveLabel);
-            window.draw(scoreText);
-            window.draw(scoreLabel);
-            window.display();
+            // Every match of a cascade gets its own voice
+            if (currentMatchPoints > 0)
+                sounds.trigger(SOUND_MATCH);
         }
 
         // =============================================
         // Game State: 2 - Level 2 (Time-based)
         // =============================================
         else if (gameState == 2) {
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-
-                // Tile selection
-                else if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left) {
-                    if (gameState == 2 && !isSwapping && !isMoving) {
-                        mousePos = Mouse::getPosition(window) - boardOffset;
-
-                        // Validate click is within bounds
-                        int col = mousePos.x / TILE_SIZE;
-                        int row = mousePos.y / TILE_SIZE;
-                        if (col >= 0 && col < 8 && row >= 0 && row < 8) {
-                            clickCount++;
-                        }
-                    }
-                }
+            ProfileScope events(PHASE_EVENTS);
+            InputEvent command;
+            while (nextInput(command)) {
+                const Event& event = command.event;
+                // Tile selection, handled as it arrives
+                if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left)
+                    handleClick(command);
                 // Keyboard controls
                 else if (event.type == Event::KeyPressed) {
                     if (event.key.code == Keyboard::P) gameState = 3; // Pause
+                    if (event.key.code == Keyboard::H) showHint = suggestMove(hintMove); // Hint
+                    if (event.key.code == Keyboard::A) autoplay = !autoplay; // Autoplay
                     if (event.key.code == Keyboard::X) {
+                        saveReplay();
                         gameState = 5; // Reset game
-                        totalScore = 0;
+                        board.totalScore = 0;
                         clockStarted = false;
-                        hasGameStarted = false;
-                        clearInitialMatches();
+                        board.hasGameStarted = false;
                         totalPausedTime = sf::Time::Zero;
                     }
                 }
             }
+            events.stop();
 
             // Initialize clock if not started
             if (!clockStarted) {
                 clock.restart();
                 clockStarted = true;
-                totalScore = 0;
-                remainingMoves = 10;
+                board.totalScore = 0;
+                remainingMoves = LEVEL1_MOVES;
             }
 
             // Calculate remaining time
             float elapsed = clock.getElapsedTime().asSeconds();
-            int timeLeft = static_cast<int>(timeLimit - elapsed);
+            timeLeft = static_cast<int>(timeLimit - elapsed);
 
             // Check if time is up
             if (timeLeft <= 0) {
+                saveReplay();
                 gameState = 4; // Game over
-                backgroundMusic.stop();
+                if (musicReady)
+                    backgroundMusic.stop();
                 continue;
             }
             
-            // Handle tile selection and swapping (same as level 1)
-            if (clickCount == 1) {
-                selectedX0 = mousePos.x / TILE_SIZE + 1;
-                selectedY0 = mousePos.y / TILE_SIZE + 1;
-            } 
-            else if (clickCount == 2) {
-                selectedX = mousePos.x / TILE_SIZE + 1;
-                selectedY = mousePos.y / TILE_SIZE + 1;
-
-                if (abs(selectedX - selectedX0) + abs(selectedY - selectedY0) == 1) {
-                    swapTiles(grid[selectedY0][selectedX0], grid[selectedY][selectedX]);
-                    isSwapping = true;
-                    clickCount = 0;
-                    remainingMoves--;
-                    hasGameStarted = true;
-                    click.play();
-                } else {
-                    clickCount = 1;
-                }
-            }
-
-            // Check for matches (same as level 1)
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    if (grid[row][col].species == grid[row + 1][col].species &&
-                        grid[row][col].species == grid[row - 1][col].species) {
-                        for (int offset = -1; offset <= 1; offset++) {
-                            grid[row + offset][col].matched++;
-                        }
-                    }
-
-                    if (grid[row][col].species == grid[row][col + 1].species &&
-                        grid[row][col].species == grid[row][col - 1].species) {
-                        for (int offset = -1; offset <= 1; offset++) {
-                            grid[row][col + offset].matched++;
-                        }
-                    }
-                }
-            }
-
-            // Tile movement animation (same as level 1)
-            isMoving = false;
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    Tile& tile = grid[row][col];
-                    int dx, dy;
-                    for (int step = 0; step < 10; step++) {
-                        dx = tile.x - tile.col * TILE_SIZE;
-                        dy = tile.y - tile.row * TILE_SIZE;
-                        if (dx) tile.x -= dx / abs(dx);
-                        if (dy) tile.y -= dy / abs(dy);
-                    }
-                    if (dx || dy) isMoving = true;
-                }
-            }
-
-            // Fade out matched tiles (same as level 1)
-            if (!isMoving) {
-                for (int row = 1; row <= 8; row++) {
-                    for (int col = 1; col <= 8; col++) {
-                        if (grid[row][col].matched && grid[row][col].alpha > 10) {
-                            grid[row][col].alpha -= 10;
-                            isMoving = true;
-                        }
-                    }
-                }
-            }
-
-            // Calculate current match points (same as level 1)
-            int currentMatchPoints = 0;
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    currentMatchPoints += grid[row][col].matched;
-                }
-            }
-
-            // Play match sound if needed (same as level 1)
-            if (currentMatchPoints > 0) {
-                if (match.getStatus() != sf::Sound::Playing) {
-                    match.play();
-                }
-            }
-
-            // Update score (same as level 1)
-            if (hasGameStarted) {
-                totalScore += currentMatchPoints;
-            }
-
-            // Handle invalid swaps (same as level 1)
-            if (isSwapping && !isMoving) {
-                if (!currentMatchPoints) {
-                    swapTiles(grid[selectedY0][selectedX0], grid[selectedY][selectedX]);
-                }
-                isSwapping = false;
-            }
-
-            // Apply gravity to tiles (same as level 1)
-            applyGravity(isMoving, currentMatchPoints, isSwapping);
-
-            // Replace matched tiles with new ones (same as level 1)
-            for (int col = 1; col <= 8; col++) {
-                for (int row = 8, dropCount = 0; row > 0; row--) {
-                    if (grid[row][col].matched) {
-                        grid[row][col].species = rand() % 7;
-                        grid[row][col].y = -TILE_SIZE * dropCount++;
-                        grid[row][col].matched = 0;
-                        grid[row][col].alpha = 255;
-                    }
-                }
-            }
-
-            // Draw game elements
-            window.draw(background);
-
-            // Draw tiles (same as level 1)
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    Tile tile = grid[row][col];
-                    animalSprites.setTextureRect(IntRect(tile.species * 49, 0, 49, 49));
-                    animalSprites.setColor(Color(255, 255, 255, tile.alpha));
-                    animalSprites.setPosition(tile.x, tile.y);
-                    animalSprites.move(boardOffset.x - TILE_SIZE, boardOffset.y - TILE_SIZE);
-                    window.draw(animalSprites);
-                }
-            }
-            
-            // Draw UI elements specific to level 2
-            Text timeText, scoreText, scoreLabel;
-
-            // Score display
-            scoreText.setFont(gameFont);
-            scoreText.setCharacterSize(27);
-            scoreText.setString(to_string(totalScore));
-            scoreText.setFillColor(Color::Yellow);
-            scoreText.setPosition(600, 190);
-            scoreText.setStyle(Text::Bold);
-
-            scoreLabel.setFont(gameFont);
-            scoreLabel.setCharacterSize(27);
-            scoreLabel.setString("Score: ");
-            scoreLabel.setFillColor(Color::Yellow);
-            scoreLabel.setPosition(500, 190);
-            scoreLabel.setStyle(Text::Bold);
-
-            window.draw(scoreText);
-            window.draw(scoreLabel);
-
-            // Time display
-            timeText.setFont(gameFont);
-            timeText.setCharacterSize(27);
-            timeText.setFillColor(Color::Yellow);
-            timeText.setPosition(500, 150);
-            timeText.setStyle(Text::Bold);
-            timeText.setString("Time Left: " + to_string(timeLeft) + "s");
-            window.draw(timeText);
-
-            window.display();
+            ProfileScope selection(PHASE_SELECTION);
+            // Autoplay takes over the swap once the board has settled
+            updateSolver();
+            Move autoMove;
+            if (autoplayMove(autoMove)) {
+                replay.recordSwap(board.tickCount, autoMove);
+                board.beginSwap(autoMove.row0, autoMove.col0, autoMove.row1, autoMove.col1);
+                selectedRow = selectedCol = 0;
+                afterSwap();
+            }
+            selection.stop();
+
+            // Run the board logic ticks due this frame (matching, animation, scoring, refill)
+            int currentMatchPoints = board.advance(stepSeconds);
+
+            // Every match of a cascade gets its own voice
+            if (currentMatchPoints > 0)
+                sounds.trigger(SOUND_MATCH);
         }
         
         // =============================================
         // Game State: 3 - Pause Screen
         // =============================================
         else if (gameState == 3) {
-            window.clear();
-            window.draw(pauseScreen);
-            backgroundMusic.pause();
-            window.display();
-
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-                    
+            if (musicReady)
+                backgroundMusic.pause();
+            InputEvent command;
+            while (nextInput(command)) {
+                const Event& event = command.event;
                 // Resume game
                 if (event.type == Event::KeyPressed && event.key.code == Keyboard::S) {
                     gameState = previousGameState; // Resume the correct level
                     totalPausedTime += clock.getElapsedTime() - pausedTime;
                     isPaused = false;
-                    backgroundMusic.play();
+                    if (musicReady)
+                        backgroundMusic.play();
                 }
             }
         }
@@ -670,27 +638,19 @@ int main() {
         else if (gameState == 4) {
             // Play game over sound once
             if (!gameOverSoundPlayed) {
-                if (gameover.getStatus() != sf::Sound::Playing) {
-                    gameover.play();
-                }
+                sounds.trigger(SOUND_GAMEOVER);
                 gameOverSoundPlayed = true;
             }
-            
-            window.draw(restartScreen);
-            window.display();
-
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-                    
+
+            InputEvent command;
+            while (nextInput(command)) {
+                const Event& event = command.event;
                 // Reset game
                 if (event.type == Event::KeyPressed && event.key.code == Keyboard::X) {
                     gameState = 5;
-                    totalScore = 0;
+                    board.totalScore = 0;
                     clockStarted = false;
-                    hasGameStarted = false;
-                    clearInitialMatches();
+                    board.hasGameStarted = false;
                     gameOverSoundPlayed = false;
                 }
             }
@@ -700,48 +660,29 @@ int main() {
         // Game State: 5 - Reset Game
         // =============================================
         else if (gameState == 5) {
-            remainingMoves = 10;
-            totalScore = 0;
-            window.clear();
-            
-            srand(time(0));
-
-            // Reinitialize grid
-            for (int row = 1; row <= 8; row++) {
-                for (int col = 1; col <= 8; col++) {
-                    grid[row][col].species = rand() % 3;
-                    grid[row][col].col = col;
-                    grid[row][col].row = row;
-                    grid[row][col].x = col * TILE_SIZE;
-                    grid[row][col].y = row * TILE_SIZE;
-                }
-            }
+            remainingMoves = LEVEL1_MOVES;
+            board.totalScore = 0;
 
+            // The next level takes a ready game from the pool itself
             gameState = 0; // Return to start screen
-            backgroundMusic.play();
+            if (musicReady)
+                backgroundMusic.play();
         }
         
         // =============================================
         // Game State: 6 - Level 2 Intro Screen
         // =============================================
         else if (gameState == 6) {
-            window.draw(level2Screen);
-            window.display();
-            gameover.play();
-
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-
-                else if (event.type == Event::KeyPressed) {
+            InputEvent command;
+            while (nextInput(command)) {
+                const Event& event = command.event;
+                if (event.type == Event::KeyPressed) {
                     // Start level 2
                     if (event.key.code == Keyboard::E) {
                         gameState = 2;
                         clockStarted = false;
-                        remainingMoves = 10;
-                        totalScore = 0;
-                        clearInitialMatches();
+                        remainingMoves = LEVEL1_MOVES;
+                        startLevel();
                     } 
                     // Return to main menu
                     else if (event.key.code == Keyboard::X) {
@@ -749,10 +690,217 @@ int main() {
                     }
                 }
             }
+        }
+    }
+
+}
+
+int main() {
+    launchTime = chrono::steady_clock::now();
+
+    // Asset archive, built by pack_assets and read through a memory mapping
+    AssetArchive assets;
+    if (!assets.open("assets.pak")) {
+        cout << "Failed to open assets.pak (build it with pack_assets)\n";
+        return 1;
+    }
+    const char* const spriteNames[] = {"sprites/background.png", "sprites/animals.png", "sprites/start.png",
+                                       "sprites/pause.png", "sprites/restart.png", "sprites/level2.png"};
+    for (const char* name : spriteNames) {
+        if (!assets.region(name)) {
+            cout << "Missing " << name << " in assets.pak\n";
+            return 1;
+        }
+    }
 
-            window.display();
+    // Decoding starts right away, in parallel, while the window is created.
+    // What the start screen and the first level need is critical; the game
+    // over sound and the music may arrive later.
+    Image atlasImage;
+    Font gameFont;
+    bool musicOpened = false;
+    AssetLoader loader;
+    loader.add(ATLAS_NAME, true, decodeTask(assets, ATLAS_NAME, atlasImage));
+    loader.add("fonts/hello.ttf", true, decodeTask(assets, "fonts/hello.ttf", gameFont));
+    loader.add("sounds/match.wav", true, decodeTask(assets, "sounds/match.wav", matchBuffer));
+    loader.add("sounds/click.wav", true, decodeTask(assets, "sounds/click.wav", clickBuffer));
+    loader.add("sounds/gameover.wav", false, decodeTask(assets, "sounds/gameover.wav", gameoverBuffer));
+    loader.add("sounds/Rainbows.wav", false, [&assets, &musicOpened] {
+        size_t size;
+        const void* data = assets.data("sounds/Rainbows.wav", size);
+        musicOpened = data && backgroundMusic.openFromMemory(data, size);
+        return musicOpened;
+    });
+
+    // Window setup
+    RenderWindow window(VideoMode(790, 475), "MENAGERIE");
+    window.setFramerateLimit(FRAME_RATE_LIMIT);
+
+    if (!loader.waitCritical())
+        return 1;
+    cout << "Critical assets decoded after " << millisecondsSinceLaunch() << " ms\n";
+
+    // Every sprite is a rectangle of the one atlas texture
+    Texture texAtlas;
+    if (!texAtlas.loadFromImage(atlasImage)) {
+        cout << "Failed to create the sprite atlas texture\n";
+        return 1;
+    }
+    Sprite background = atlasSprite(texAtlas, *assets.region("sprites/background.png")),
+           startScreen = atlasSprite(texAtlas, *assets.region("sprites/start.png")),
+           pauseScreen = atlasSprite(texAtlas, *assets.region("sprites/pause.png")),
+           level2Screen = atlasSprite(texAtlas, *assets.region("sprites/level2.png")),
+           restartScreen = atlasSprite(texAtlas, *assets.region("sprites/restart.png"));
+
+    // UI Text elements
+    Hud hud(gameFont);
+
+    // All 64 tiles are drawn as one vertex array
+    const AssetEntry& animals = *assets.region("sprites/animals.png");
+    BoardRenderer boardRenderer(texAtlas, Vector2i(animals.x, animals.y), boardOffset);
+
+    // Level frames are composited over a cached background; only the areas
+    // of changed tiles and HUD values are redrawn
+    Compositor compositor;
+    if (!compositor.create(window.getSize().x, window.getSize().y))
+        cout << "Failed to create the frame layers\n";
+    vector<FloatRect> dirty;    // Screen areas changed this frame
+
+    // Profilers for the logic steps (shown with F3) and the drawn frames,
+    // dumped to profile.csv and profile-render.csv on exit
+    profiler.enabled = true;
+    renderProfiler.enabled = true;
+    ProfilerOverlay profilerOverlay(gameFont, Vector2f(530, 228), 1000000.0f / TICK_RATE);
+    bool showProfiler = false;
+
+    // Sound setup; the game over sound and the music are hooked up once
+    // they finish loading
+    sounds.setBuffer(SOUND_MATCH, matchBuffer);
+    sounds.setBuffer(SOUND_CLICK, clickBuffer);
+
+    // The game runs on its own thread from here on
+    thread logic(runLogic, ref(loader), cref(musicOpened));
+
+    // Render loop: forwards input and draws the newest snapshot
+    sf::Clock frameClock;
+    int shownState = -1;    // Game state of the last frame
+    bool hintShown = false; // Hint state of the last frame
+    Move hintShownMove = Move();
+    uint32_t measuredSwaps = 0; // Click swaps whose latency is recorded
+    while (window.isOpen()) {
+        frameClock.restart();
+        renderProfiler.nextFrame();
+
+        ProfileScope events(PHASE_EVENTS, renderProfiler);
+        Event event;
+        while (nextEvent(window, event, frameClock)) {
+            if (event.type == Event::Closed)
+                window.close();
+            else if (event.type != Event::MouseMoved)
+                sendInput(event);
+
+            if (event.type == Event::KeyPressed && event.key.code == Keyboard::F3)
+                showProfiler = !showProfiler; // Profiler overlay
+        }
+        events.stop();
+
+        snapshots.update();
+        const GameSnapshot& shown = snapshots.readBuffer();
+
+        // A new screen is always drawn
+        bool screenChanged = shown.gameState != shownState;
+        if (screenChanged) {
+            shownState = shown.gameState;
+            redrawNeeded = true;
+        }
+
+        // The hint is drawn over the composited frame, so showing, moving or
+        // hiding it changes nothing the compositor tracks
+        const Move& hint = shown.hintMove;
+        if (shown.showHint != hintShown ||
+            (shown.showHint && (hint.row0 != hintShownMove.row0 || hint.col0 != hintShownMove.col0 ||
+                                hint.row1 != hintShownMove.row1 || hint.col1 != hintShownMove.col1))) {
+            hintShown = shown.showHint;
+            hintShownMove = hint;
+            redrawNeeded = true;
+        }
+
+        ProfileScope draw(PHASE_DRAW, renderProfiler);
+        if (shown.gameState == 1 || shown.gameState == 2) {
+            // Composite the areas of changed tiles and HUD values; the window
+            // is only redrawn if the frame or the input changed what is on
+            // screen (the profiler overlay always does)
+            hud.setTimed(shown.gameState == 2);
+            hud.setScore(shown.board.totalScore);
+            if (shown.gameState == 1)
+                hud.setMoves(shown.remainingMoves);
+            else
+                hud.setTimeLeft(shown.timeLeft);
+            if (screenChanged)
+                buildStaticLayer(compositor, background, hud);
+            boardRenderer.update(shown.board, dirty);
+            hud.takeDirty(dirty);
+            compositor.invalidate(dirty);
+            if (compositor.compose({&boardRenderer, &hud}) || showProfiler)
+                redrawNeeded = true;
+
+            if (redrawNeeded) {
+                window.draw(compositor);
+                if (shown.showHint) drawHint(window, shown.hintMove);
+                if (showProfiler) {
+                    profilerOverlay.update(profiler);
+                    window.draw(profilerOverlay);
+                }
+            }
+        }
+        else if (shown.gameState == 0) drawStill(window, startScreen);
+        else if (shown.gameState == 3) drawStill(window, pauseScreen);
+        else if (shown.gameState == 4) drawStill(window, restartScreen);
+        else if (shown.gameState == 6) drawStill(window, level2Screen);
+        else redrawNeeded = false;  // The reset passes straight back to the start screen
+        draw.stop();
+
+        // Block on events only once the logic has seen every input and
+        // has nothing left to change without more
+        ProfileScope display(PHASE_DISPLAY, renderProfiler);
+        bool presenting = redrawNeeded;
+        finishFrame(window, frameClock, shown.idle && shown.inputSeen == inputSent);
+        display.stop();
+
+        // The first frame shown with a new click swap closes its latency probe
+        if (presenting && shown.clickSwaps != measuredSwaps) {
+            measuredSwaps = shown.clickSwaps;
+            auto presented = chrono::steady_clock::now();
+            clickToSwap.add(chrono::duration_cast<chrono::microseconds>(shown.swapStarted - shown.swapClicked).count());
+            swapToPresent.add(chrono::duration_cast<chrono::microseconds>(presented - shown.swapStarted).count());
+            clickToPresent.add(chrono::duration_cast<chrono::microseconds>(presented - shown.swapClicked).count());
         }
     }
 
+    // Stop the game before its state is saved
+    quitLogic = true;
+    {
+        lock_guard<mutex> guard(inputLock);
+        inputArrived.notify_one();
+    }
+    logic.join();
+
+    // The music streams straight out of the mapped archive, so it has to
+    // stop before the archive is unmapped at the end of main(). It may still
+    // be opening on a loader thread if the window closed early.
+    loader.waitAll();
+    if (musicOpened)
+        backgroundMusic.stop();
+
+    saveReplay();
+    if (!profiler.writeCsv("profile.csv"))
+        cout << "Failed to write profile.csv\n";
+    if (!renderProfiler.writeCsv("profile-render.csv"))
+        cout << "Failed to write profile-render.csv\n";
+    if (clickToPresent.count() > 0) {
+        clickToSwap.print(cout, "Click to swap start");
+        swapToPresent.print(cout, "Swap start to frame shown");
+        clickToPresent.print(cout, "Click to frame shown");
+    }
     return 0;
 }
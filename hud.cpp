@@ -0,0 +1,100 @@
+#include "hud.h"
+#include <string>
+
+using namespace std;
+
+/**
+ * Applies the shared HUD text style
+ */
+static void setupText(sf::Text& text, const sf::Font& font, unsigned size, float x, float y) {
+    text.setFont(font);
+    text.setCharacterSize(size);
+    text.setFillColor(sf::Color::Yellow);
+    text.setStyle(sf::Text::Bold);
+    text.setPosition(x, y);
+}
+
+Hud::Hud(const sf::Font& font) {
+    score = moves = timeLeft = -1;
+    timed = false;
+
+    // Static labels are laid out once
+    setupText(moveLabel, font, 30, 500, 160);
+    moveLabel.setString("Moves: ");
+    setupText(moveText, font, 30, 600, 160);
+
+    setupText(scoreLabel, font, 27, 500, 190);
+    scoreLabel.setString("Score: ");
+    setupText(scoreText, font, 27, 600, 190);
+
+    setupText(timeLabel, font, 27, 500, 150);
+    timeLabel.setString("Time Left: ");
+    sf::Vector2f labelEnd = timeLabel.findCharacterPos(11);
+    setupText(timeText, font, 27, labelEnd.x, 150);
+}
+
+void Hud::setScore(int value) {
+    if (value == score)
+        return;
+    score = value;
+    setValue(scoreText, to_string(value));
+}
+
+void Hud::setMoves(int value) {
+    if (value == moves)
+        return;
+    moves = value;
+    setValue(moveText, to_string(value));
+}
+
+void Hud::setTimeLeft(int value) {
+    if (value == timeLeft)
+        return;
+    timeLeft = value;
+    setValue(timeText, to_string(value) + "s");
+}
+
+void Hud::setTimed(bool value) {
+    if (value == timed)
+        return;
+    timed = value;
+    changes.push_back(moveText.getGlobalBounds());
+    changes.push_back(timeText.getGlobalBounds());
+}
+
+bool Hud::takeDirty(vector<sf::FloatRect>& dirty) {
+    if (changes.empty())
+        return false;
+    dirty.insert(dirty.end(), changes.begin(), changes.end());
+    changes.clear();
+    return true;
+}
+
+void Hud::drawLabels(sf::RenderTarget& target) const {
+    if (timed) {
+        target.draw(scoreLabel);
+        target.draw(timeLabel);
+    } else {
+        target.draw(moveLabel);
+        target.draw(scoreLabel);
+    }
+}
+
+/**
+ * Re-lays out a value, recording the area of the old and the new text
+ */
+void Hud::setValue(sf::Text& text, const string& value) {
+    changes.push_back(text.getGlobalBounds());
+    text.setString(value);
+    changes.push_back(text.getGlobalBounds());
+}
+
+void Hud::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (timed) {
+        target.draw(scoreText, states);
+        target.draw(timeText, states);
+    } else {
+        target.draw(moveText, states);
+        target.draw(scoreText, states);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef MENAGERIE_HUD_H
+#define MENAGERIE_HUD_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+// Score, moves and time display. The text objects live as long as the HUD;
+// labels are laid out once and a value is re-laid out only when it changes.
+// The labels never change within a level, so they are drawn separately
+// (into the compositor's static layer) from the values.
+
+class Hud : public sf::Drawable {
+public:
+    explicit Hud(const sf::Font& font);
+
+    void setScore(int score);
+    void setMoves(int moves);
+    void setTimeLeft(int seconds);
+
+    /**
+     * Shows the time left (level 2) instead of the moves left (level 1);
+     * the labels have to be drawn again after a change
+     */
+    void setTimed(bool timed);
+
+    /**
+     * Moves the screen areas of the values changed since the last call
+     * into dirty; returns true if there were any
+     */
+    bool takeDirty(std::vector<sf::FloatRect>& dirty);
+
+    /**
+     * Draws the labels of the current mode; draw() only draws the values
+     */
+    void drawLabels(sf::RenderTarget& target) const;
+
+private:
+    sf::Text scoreLabel, scoreText;
+    sf::Text moveLabel, moveText;
+    sf::Text timeLabel, timeText;
+
+    // Values currently shown (-1 = nothing yet)
+    int score, moves, timeLeft;
+    bool timed;
+    std::vector<sf::FloatRect> changes;    // Areas of changed values
+
+    void setValue(sf::Text& text, const std::string& value);
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+const int HISTOGRAM_BAR_WIDTH = 40;     // Characters of the fullest bucket's bar
+
+LatencyHistogram::LatencyHistogram() {
+    fill(buckets, buckets + LATENCY_BUCKETS, 0);
+    samples = 0;
+    maximum = 0;
+}
+
+void LatencyHistogram::add(int64_t microseconds) {
+    microseconds = max<int64_t>(microseconds, 0);
+    buckets[bucketOf(microseconds)]++;
+    samples++;
+    maximum = max(maximum, microseconds);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+        buckets[bucket] += other.buckets[bucket];
+    samples += other.samples;
+    maximum = max(maximum, other.maximum);
+}
+
+int64_t LatencyHistogram::count() const {
+    return samples;
+}
+
+int64_t LatencyHistogram::percentile(double fraction) const {
+    int64_t rank = int64_t(fraction * samples);
+    int64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += buckets[bucket];
+        if (seen > rank)
+            return min(bucketEnd(bucket), maximum);
+    }
+    return maximum;
+}
+
+void LatencyHistogram::print(ostream& out, const string& title) const {
+    char line[128];
+    snprintf(line, sizeof(line), "%s: %lld samples, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+             title.c_str(), (long long)samples, percentile(0.5) / 1000.0, percentile(0.9) / 1000.0,
+             percentile(0.99) / 1000.0, maximum / 1000.0);
+    out << line;
+    if (samples == 0)
+        return;
+
+    int64_t fullest = *max_element(buckets, buckets + LATENCY_BUCKETS);
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        if (buckets[bucket] == 0)
+            continue;
+        int64_t start = bucket == 0 ? 0 : bucketEnd(bucket - 1);
+        int width = int(buckets[bucket] * HISTOGRAM_BAR_WIDTH / fullest);
+        snprintf(line, sizeof(line), "  %8.2f - %8.2f ms  %-*s %lld\n", start / 1000.0, bucketEnd(bucket) / 1000.0,
+                 HISTOGRAM_BAR_WIDTH, string(width, '#').c_str(), (long long)buckets[bucket]);
+        out << line;
+    }
+}
+
+/**
+ * Values below 4 us get a bucket each; above that every doubling is split
+ * into four buckets by the two bits below the highest set bit
+ */
+int LatencyHistogram::bucketOf(int64_t microseconds) {
+    if (microseconds < 4)
+        return int(microseconds);
+    int highBit = 63 - __builtin_clzll(uint64_t(microseconds));
+    int bucket = 4 * (highBit - 1) + int((microseconds >> (highBit - 2)) & 3);
+    return min(bucket, LATENCY_BUCKETS - 1);
+}
+
+/**
+ * First value past a bucket
+ */
+int64_t LatencyHistogram::bucketEnd(int bucket) {
+    if (bucket < 4)
+        return bucket + 1;
+    int highBit = bucket / 4 + 1;
+    return int64_t(5 + bucket % 4) << (highBit - 2);
+}
@@ -0,0 +1,47 @@
+#ifndef MENAGERIE_LATENCY_HISTOGRAM_H
+#define MENAGERIE_LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Histogram of latencies in microseconds. Buckets grow geometrically, four
+// per doubling, so a 1 ms click and a 100 ms driver stall are both kept to
+// within 25%. Adding a sample is a few instructions and never allocates.
+// Nothing in here depends on SFML.
+
+const int LATENCY_BUCKETS = 4 * 28;     // Up to 2^28 us (about 4.5 minutes)
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(int64_t microseconds);
+
+    /**
+     * Adds every sample of another histogram, e.g. one kept per thread
+     */
+    void merge(const LatencyHistogram& other);
+
+    int64_t count() const;
+
+    /**
+     * Upper bound of the bucket that holds the given fraction of samples
+     */
+    int64_t percentile(double fraction) const;
+
+    /**
+     * Prints the sample count, p50/p90/p99/max and a bar per non-empty bucket
+     */
+    void print(std::ostream& out, const std::string& title) const;
+
+private:
+    int64_t buckets[LATENCY_BUCKETS];
+    int64_t samples;
+    int64_t maximum;
+
+    static int bucketOf(int64_t microseconds);
+    static int64_t bucketEnd(int bucket);
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "latency_histogram.h"
+#include "rng.h"
+#include "session_protocol.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+// Load generator for the session server: opens many sessions over a few
+// connections, keeps one random swap in flight per session and reports
+// swap throughput and round-trip latency.
+//
+// Usage: load_test [socket path] [sessions] [swaps per session] [connections]
+
+// What one connection thread measured
+struct ClientResult {
+    LatencyHistogram roundTrip;
+    long long swaps = 0;
+    long long scoreSum = 0;
+    long long errors = 0;
+    bool failed = false;
+};
+
+// A session as the client sees it
+struct ClientSession {
+    uint32_t id;
+    int swapsLeft;
+    chrono::steady_clock::time_point sent;
+};
+
+static int connectTo(const string& path) {
+    sockaddr_un address = sockaddr_un();
+    if (path.size() >= sizeof(address.sun_path))
+        return -1;
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor >= 0 && connect(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(descriptor);
+        descriptor = -1;
+    }
+    return descriptor;
+}
+
+static bool sendAll(int descriptor, vector<uint8_t>& bytes) {
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+        ssize_t count = send(descriptor, bytes.data() + sent, bytes.size() - sent, 0);
+        if (count <= 0)
+            return false;
+        sent += size_t(count);
+    }
+    bytes.clear();
+    return true;
+}
+
+/**
+ * Plays sessionCount sessions on one connection until each has made its
+ * swaps and been closed
+ */
+static void playSessions(const string& path, int sessionCount, int swapsPerSession, uint64_t seed,
+                         ClientResult& result) {
+    int descriptor = connectTo(path);
+    if (descriptor < 0) {
+        result.failed = true;
+        return;
+    }
+
+    Rng picker(seed);
+    vector<ClientSession> sessions(sessionCount);
+    vector<uint8_t> output, input;
+    FrameWriter frame(output);
+
+    // Queues a random swap, right or down from a random tile of a board of
+    // the size STARTED announced
+    int width = 0, height = 0;
+    auto sendSwap = [&](ClientSession& session) {
+        int row = picker.below(height), col = picker.below(width);
+        bool vertical = picker.below(2);
+        if (vertical && row == height - 1) row--;
+        if (!vertical && col == width - 1) col--;
+        frame.begin(MESSAGE_SWAP);
+        frame.put(session.id, 4);
+        frame.put(uint8_t(row * width + col) | (vertical ? SWAP_VERTICAL : 0), 1);
+        frame.finish();
+        session.sent = chrono::steady_clock::now();
+    };
+
+    for (int i = 0; i < sessionCount; i++) {
+        frame.begin(MESSAGE_NEW);
+        frame.put(uint32_t(i), 4);
+        frame.put(picker.next() | uint64_t(picker.next()) << 32, 8);
+        frame.put(0, 2);
+        frame.put(0, 2);
+        frame.finish();
+    }
+
+    int open = sessionCount;
+    vector<ClientSession*> byId;
+    uint8_t buffer[16384];
+    while (open > 0) {
+        if (!sendAll(descriptor, output)) {
+            result.failed = true;
+            break;
+        }
+        ssize_t count = recv(descriptor, buffer, sizeof(buffer), 0);
+        if (count <= 0) {
+            result.failed = true;
+            break;
+        }
+        input.insert(input.end(), buffer, buffer + count);
+
+        size_t position = 0, length;
+        while ((length = frameLength(input.data() + position, input.size() - position))) {
+            const uint8_t* message = input.data() + position;
+            FrameReader reader{message + 3, length - 3, 0};
+            position += length;
+
+            uint64_t first = 0, second = 0, value = 0;
+            reader.get(first, 4);
+            if (message[2] == MESSAGE_STARTED) {
+                // Tag is the session's index here; the server's id follows
+                reader.get(second, 4);
+                reader.get(value, 8);
+                reader.get(value, 1);
+                width = int(value);
+                reader.get(value, 1);
+                height = int(value);
+                ClientSession& session = sessions[first];
+                session.id = uint32_t(second);
+                session.swapsLeft = swapsPerSession;
+                if (byId.size() <= second)
+                    byId.resize(second + 1);
+                byId[second] = &session;
+            } else if (message[2] == MESSAGE_DELTA && first < byId.size() && byId[first]) {
+                ClientSession& session = *byId[first];
+                auto now = chrono::steady_clock::now();
+                result.roundTrip.add(chrono::duration_cast<chrono::microseconds>(now - session.sent).count());
+                result.swaps++;
+                session.swapsLeft--;
+            } else if (message[2] == MESSAGE_ENDED) {
+                reader.get(value, 4);
+                result.scoreSum += int32_t(value);
+                open--;
+                continue;
+            } else {
+                result.errors++;
+                continue;
+            }
+
+            ClientSession& session = *byId[message[2] == MESSAGE_STARTED ? second : first];
+            if (session.swapsLeft > 0) {
+                sendSwap(session);
+            } else {
+                frame.begin(MESSAGE_CLOSE);
+                frame.put(session.id, 4);
+                frame.finish();
+            }
+        }
+        input.erase(input.begin(), input.begin() + position);
+    }
+    close(descriptor);
+}
+
+int main(int argc, char* argv[]) {
+    string path = argc > 1 ? argv[1] : "menagerie.sock";
+    int sessions = argc > 2 ? atoi(argv[2]) : 1000;
+    int swapsPerSession = argc > 3 ? atoi(argv[3]) : 100;
+    int connections = argc > 4 ? atoi(argv[4]) : 4;
+    if (sessions < 1 || swapsPerSession < 1 || connections < 1) {
+        cout << "Usage: load_test [socket path] [sessions] [swaps per session] [connections]\n";
+        return 1;
+    }
+    if (connections > sessions)
+        connections = sessions;
+
+    vector<ClientResult> results(connections);
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < connections; i++) {
+        int count = sessions / connections + (i < sessions % connections);
+        threads.emplace_back(playSessions, path, count, swapsPerSession, uint64_t(i + 1), ref(results[i]));
+    }
+    for (thread& client : threads)
+        client.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    LatencyHistogram roundTrip;
+    long long swaps = 0, scoreSum = 0, errors = 0;
+    bool failed = false;
+    for (const ClientResult& result : results) {
+        roundTrip.merge(result.roundTrip);
+        swaps += result.swaps;
+        scoreSum += result.scoreSum;
+        errors += result.errors;
+        failed = failed || result.failed;
+    }
+
+    cout << "sessions:     " << sessions << " over " << connections << " connections\n";
+    cout << "swaps:        " << swaps << "\n";
+    cout << "errors:       " << errors << "\n";
+    cout << "mean score:   " << double(scoreSum) / sessions << "\n";
+    cout << "elapsed:      " << seconds << " s\n";
+    cout << "swaps/sec:    " << (seconds > 0 ? swaps / seconds : 0.0) << "\n";
+    roundTrip.print(cout, "Swap round trip");
+    if (failed)
+        cout << "Lost the connection to " << path << "\n";
+    return failed || errors ? 1 : 0;
+}
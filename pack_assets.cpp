@@ -0,0 +1,152 @@
+#include <SFML/Graphics.hpp>
+#include "asset_archive.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// Build step for the game's assets: packs sprites/, sounds/ and fonts/ into
+// one archive, with every sprite packed into a single texture atlas. Run it
+// from the game directory whenever an asset changes.
+//
+// Usage: pack_assets [output.pak]
+
+const char* const ASSET_DIRECTORIES[] = {"sprites", "sounds", "fonts"};
+const unsigned ATLAS_MAX_SIZE = 4096;   // Widest/tallest texture we rely on
+const unsigned ATLAS_MAX_WIDTH = 2048;  // Shelf width the sprites are laid out in
+const unsigned ATLAS_PADDING = 1;       // Gap between sprites, so filtering never bleeds
+
+// A sprite waiting for its place in the atlas
+struct PackedSprite {
+    string name;
+    sf::Image image;
+    unsigned x, y;
+};
+
+static bool readFile(const fs::path& path, vector<char>& bytes) {
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+/**
+ * Lays the sprites out on shelves, tallest first, and returns the atlas size
+ */
+static sf::Vector2u layOut(vector<PackedSprite>& sprites) {
+    sort(sprites.begin(), sprites.end(), [](const PackedSprite& a, const PackedSprite& b) {
+        unsigned heightA = a.image.getSize().y, heightB = b.image.getSize().y;
+        return heightA != heightB ? heightA > heightB : a.name < b.name;
+    });
+
+    unsigned x = 0, y = 0, shelfHeight = 0, width = 0;
+    for (PackedSprite& sprite : sprites) {
+        sf::Vector2u size = sprite.image.getSize();
+        if (x > 0 && x + size.x > ATLAS_MAX_WIDTH) {
+            x = 0;
+            y += shelfHeight + ATLAS_PADDING;
+            shelfHeight = 0;
+        }
+        sprite.x = x;
+        sprite.y = y;
+        x += size.x + ATLAS_PADDING;
+        shelfHeight = max(shelfHeight, size.y);
+        width = max(width, sprite.x + size.x);
+    }
+    return sf::Vector2u(width, y + shelfHeight);
+}
+
+int main(int argc, char* argv[]) {
+    string outputPath = argc > 1 ? argv[1] : "assets.pak";
+
+    // Sprites go into the atlas, everything else is stored as it is
+    vector<PackedSprite> sprites;
+    vector<AssetEntry> files;
+    vector<vector<char>> contents;
+    for (const char* directory : ASSET_DIRECTORIES) {
+        vector<fs::path> paths;
+        for (const fs::directory_entry& entry : fs::directory_iterator(directory))
+            if (entry.is_regular_file())
+                paths.push_back(entry.path());
+        sort(paths.begin(), paths.end());
+
+        for (const fs::path& path : paths) {
+            string name = path.generic_string();
+            if (string(directory) == "sprites" && path.extension() == ".png") {
+                PackedSprite sprite;
+                sprite.name = name;
+                if (!sprite.image.loadFromFile(name)) {
+                    cout << "Failed to load " << name << "\n";
+                    return 1;
+                }
+                sprites.push_back(sprite);
+                continue;
+            }
+
+            AssetEntry entry = AssetEntry();
+            entry.name = name;
+            contents.emplace_back();
+            if (!readFile(path, contents.back())) {
+                cout << "Failed to read " << name << "\n";
+                return 1;
+            }
+            files.push_back(entry);
+        }
+    }
+
+    sf::Vector2u atlasSize = layOut(sprites);
+    if (atlasSize.x > ATLAS_MAX_SIZE || atlasSize.y > ATLAS_MAX_SIZE) {
+        cout << "Sprites do not fit a " << ATLAS_MAX_SIZE << "x" << ATLAS_MAX_SIZE << " atlas\n";
+        return 1;
+    }
+
+    sf::Image atlas;
+    atlas.create(max(atlasSize.x, 1u), max(atlasSize.y, 1u), sf::Color::Transparent);
+    for (const PackedSprite& sprite : sprites)
+        atlas.copy(sprite.image, sprite.x, sprite.y);
+
+    // The atlas is stored PNG-compressed; SFML only encodes to a file
+    string atlasPath = outputPath + ".atlas.png";
+    vector<char> atlasBytes;
+    bool encoded = atlas.saveToFile(atlasPath) && readFile(atlasPath, atlasBytes);
+    remove(atlasPath.c_str());
+    if (!encoded) {
+        cout << "Failed to encode the atlas\n";
+        return 1;
+    }
+
+    // Index: the atlas, its regions, then the other files
+    vector<AssetEntry> entries;
+    vector<vector<char>> entryContents;
+    AssetEntry atlasEntry = AssetEntry();
+    atlasEntry.name = ATLAS_NAME;
+    entries.push_back(atlasEntry);
+    entryContents.push_back(atlasBytes);
+    for (const PackedSprite& sprite : sprites) {
+        AssetEntry region = AssetEntry();
+        region.name = sprite.name;
+        region.region = true;
+        region.x = uint16_t(sprite.x);
+        region.y = uint16_t(sprite.y);
+        region.width = uint16_t(sprite.image.getSize().x);
+        region.height = uint16_t(sprite.image.getSize().y);
+        entries.push_back(region);
+    }
+    entries.insert(entries.end(), files.begin(), files.end());
+    entryContents.insert(entryContents.end(), contents.begin(), contents.end());
+
+    if (!AssetArchive::write(outputPath, entries, entryContents)) {
+        cout << "Failed to write " << outputPath << "\n";
+        return 1;
+    }
+
+    cout << "Packed " << sprites.size() << " sprites into a " << atlasSize.x << "x" << atlasSize.y
+         << " atlas and " << files.size() << " other files into " << outputPath << "\n";
+    return 0;
+}
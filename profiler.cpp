@@ -0,0 +1,86 @@
+#include "profiler.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+
+Profiler profiler;
+
+static const char* PHASE_NAMES[PHASE_COUNT] = {
+    "events", "selection", "match", "animation", "fade",
+    "scoring", "gravity", "refill", "draw", "display"
+};
+
+Profiler::Profiler() : published(0) {
+    enabled = false;
+    started = false;
+    current = FrameSample();
+}
+
+void Profiler::nextFrame() {
+    if (!enabled)
+        return;
+
+    auto now = chrono::steady_clock::now();
+    if (started) {
+        uint32_t index = published.load(memory_order_relaxed);
+        current.frame = index;
+        current.total = chrono::duration<float, micro>(now - frameStart).count();
+        ring[index % PROFILE_HISTORY] = current;
+        published.store(index + 1, memory_order_release);
+    }
+
+    current = FrameSample();
+    frameStart = now;
+    started = true;
+}
+
+void Profiler::add(ProfilePhase phase, float microseconds) {
+    current.phases[phase] += microseconds;
+}
+
+vector<FrameSample> Profiler::recent(int count) const {
+    uint32_t end = published.load(memory_order_acquire);
+    uint32_t available = min<uint32_t>(end, PROFILE_HISTORY);
+    uint32_t first = end - min<uint32_t>(available, max(count, 0));
+
+    vector<FrameSample> frames;
+    frames.reserve(end - first);
+    for (uint32_t index = first; index < end; index++)
+        frames.push_back(ring[index % PROFILE_HISTORY]);
+
+    // The writer may have lapped the oldest slots while they were copied
+    uint32_t after = published.load(memory_order_acquire);
+    uint32_t safeFirst = after > PROFILE_HISTORY - 1 ? after - (PROFILE_HISTORY - 1) : 0;
+    if (safeFirst > first)
+        frames.erase(frames.begin(), frames.begin() + min<uint32_t>(safeFirst - first, frames.size()));
+    return frames;
+}
+
+bool Profiler::writeCsv(const string& path) const {
+    vector<FrameSample> frames = recent(PROFILE_HISTORY);
+    if (frames.empty())
+        return true;
+
+    ofstream out(path);
+    if (!out)
+        return false;
+
+    // All times in microseconds
+    out << "frame,total";
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+        out << "," << PHASE_NAMES[phase];
+    out << "\n";
+
+    for (const FrameSample& frame : frames) {
+        out << frame.frame << "," << frame.total;
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+            out << "," << frame.phases[phase];
+        out << "\n";
+    }
+    return bool(out);
+}
+
+const char* Profiler::phaseName(int phase) {
+    return PHASE_NAMES[phase];
+}
@@ -0,0 +1,111 @@
+#ifndef MENAGERIE_PROFILER_H
+#define MENAGERIE_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-phase frame profiler. Scoped timers add their time to the frame in
+// progress; nextFrame() publishes it into a fixed ring of recent frames.
+// The ring has one writer and is published through an atomic frame
+// counter, so readers (the overlay, the CSV dump) never take a lock.
+// Nothing in here depends on SFML.
+
+// Phases of the level loop, in the order they run
+enum ProfilePhase {
+    PHASE_EVENTS,       // Event polling, with clicks applied as they arrive
+    PHASE_SELECTION,    // Solver upkeep and autoplay swap start
+    PHASE_MATCH,        // Match scan
+    PHASE_ANIMATION,    // Tile movement
+    PHASE_FADE,         // Fading matched tiles
+    PHASE_SCORING,      // Points, swap revert, combo, dead-board check
+    PHASE_GRAVITY,      // Column compaction
+    PHASE_REFILL,       // New tiles
+    PHASE_DRAW,         // Building and submitting draw calls
+    PHASE_DISPLAY,      // Buffer swap (includes the frame limiter wait)
+    PHASE_COUNT
+};
+
+const int PROFILE_HISTORY = 4096;   // Frames kept (about a minute at 60 FPS)
+
+// Timings of one frame in microseconds
+struct FrameSample {
+    uint32_t frame;                 // Frame number since start
+    float total;                    // Whole frame, phases and everything else
+    float phases[PHASE_COUNT];
+};
+
+class Profiler {
+public:
+    bool enabled;       // Timers do nothing while false (headless tools)
+
+    Profiler();
+
+    /**
+     * Closes the frame in progress, publishes it and starts the next one
+     */
+    void nextFrame();
+
+    /**
+     * Adds time spent in a phase to the frame in progress
+     */
+    void add(ProfilePhase phase, float microseconds);
+
+    /**
+     * Copies up to count of the most recent published frames, oldest first.
+     * Frames the writer overwrote during the copy are dropped.
+     */
+    std::vector<FrameSample> recent(int count) const;
+
+    /**
+     * Writes every frame still in the ring to a CSV file, one row per frame
+     */
+    bool writeCsv(const std::string& path) const;
+
+    static const char* phaseName(int phase);
+
+private:
+    FrameSample ring[PROFILE_HISTORY];
+    std::atomic<uint32_t> published;    // Frames written to the ring so far
+    FrameSample current;
+    std::chrono::steady_clock::time_point frameStart;
+    bool started;
+};
+
+// The game's profiler; board logic reports its phases here
+extern Profiler profiler;
+
+/**
+ * Times a phase from construction until stop() or the end of the scope.
+ * Each thread reports to its own profiler; board logic uses the global one.
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfilePhase phase, Profiler& target = profiler)
+        : target(target), phase(phase), running(target.enabled) {
+        if (running)
+            start = std::chrono::steady_clock::now();
+    }
+
+    ~ProfileScope() {
+        stop();
+    }
+
+    void stop() {
+        if (!running)
+            return;
+        running = false;
+        std::chrono::duration<float, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        target.add(phase, elapsed.count());
+    }
+
+private:
+    Profiler& target;
+    ProfilePhase phase;
+    bool running;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
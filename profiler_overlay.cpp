@@ -0,0 +1,88 @@
+#include "profiler_overlay.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+const float GRAPH_WIDTH = 240;
+const float GRAPH_HEIGHT = 60;  // Twice the budget fills the graph
+const float PANEL_PADDING = 4;
+const float TABLE_HEIGHT = (PHASE_COUNT + 2) * 15;  // Header, frame and phase lines
+
+ProfilerOverlay::ProfilerOverlay(const sf::Font& font, sf::Vector2f position, float budgetMicroseconds)
+    : origin(position),
+      budget(budgetMicroseconds),
+      bars(sf::Lines, OVERLAY_FRAMES * 2),
+      budgetLine(sf::Lines, 2) {
+    framesSinceStats = OVERLAY_STATS_INTERVAL;
+
+    panel.setPosition(origin.x - PANEL_PADDING, origin.y - PANEL_PADDING);
+    panel.setSize(sf::Vector2f(GRAPH_WIDTH + 2 * PANEL_PADDING, GRAPH_HEIGHT + TABLE_HEIGHT + 3 * PANEL_PADDING));
+    panel.setFillColor(sf::Color(0, 0, 0, 180));
+
+    float budgetY = origin.y + GRAPH_HEIGHT / 2;
+    budgetLine[0] = sf::Vertex(sf::Vector2f(origin.x, budgetY), sf::Color::White, sf::Vector2f());
+    budgetLine[1] = sf::Vertex(sf::Vector2f(origin.x + GRAPH_WIDTH, budgetY), sf::Color::White, sf::Vector2f());
+
+    statsText.setFont(font);
+    statsText.setCharacterSize(12);
+    statsText.setFillColor(sf::Color::White);
+    statsText.setPosition(origin.x, origin.y + GRAPH_HEIGHT + PANEL_PADDING);
+}
+
+void ProfilerOverlay::update(const Profiler& profiler) {
+    vector<FrameSample> frames = profiler.recent(OVERLAY_FRAMES);
+
+    // Newest frame on the right; missing history stays as empty bars
+    float bottom = origin.y + GRAPH_HEIGHT;
+    float scale = GRAPH_HEIGHT / (2 * budget);
+    int offset = OVERLAY_FRAMES - int(frames.size());
+    for (int i = 0; i < OVERLAY_FRAMES; i++) {
+        float height = 0;
+        sf::Color color = sf::Color::Green;
+        if (i >= offset) {
+            const FrameSample& frame = frames[i - offset];
+            height = min(frame.total * scale, GRAPH_HEIGHT);
+            if (frame.total > budget)
+                color = sf::Color::Red;
+        }
+        float x = origin.x + i * GRAPH_WIDTH / OVERLAY_FRAMES;
+        bars[2 * i] = sf::Vertex(sf::Vector2f(x, bottom), color, sf::Vector2f());
+        bars[2 * i + 1] = sf::Vertex(sf::Vector2f(x, bottom - height), color, sf::Vector2f());
+    }
+
+    if (++framesSinceStats >= OVERLAY_STATS_INTERVAL && !frames.empty()) {
+        updateStats(frames);
+        framesSinceStats = 0;
+    }
+}
+
+/**
+ * Rebuilds the phase table: p50 and p99 in milliseconds per phase
+ */
+void ProfilerOverlay::updateStats(const vector<FrameSample>& frames) {
+    vector<float> times(frames.size());
+    char line[64];
+    string table = "phase          p50 ms   p99 ms\n";
+
+    for (int phase = -1; phase < PHASE_COUNT; phase++) {
+        for (size_t i = 0; i < frames.size(); i++)
+            times[i] = phase < 0 ? frames[i].total : frames[i].phases[phase];
+        sort(times.begin(), times.end());
+        float p50 = times[times.size() / 2];
+        float p99 = times[min(times.size() * 99 / 100, times.size() - 1)];
+
+        snprintf(line, sizeof(line), "%-12s %7.2f  %7.2f\n",
+                 phase < 0 ? "frame" : Profiler::phaseName(phase), p50 / 1000, p99 / 1000);
+        table += line;
+    }
+    statsText.setString(table);
+}
+
+void ProfilerOverlay::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    target.draw(panel, states);
+    target.draw(bars, states);
+    target.draw(budgetLine, states);
+    target.draw(statsText, states);
+}
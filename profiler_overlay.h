@@ -0,0 +1,36 @@
+#ifndef MENAGERIE_PROFILER_OVERLAY_H
+#define MENAGERIE_PROFILER_OVERLAY_H
+
+#include <SFML/Graphics.hpp>
+#include "profiler.h"
+
+// In-game view of the profiler: a bar per recent frame against the frame
+// budget, and p50/p99 per phase. The graph follows every frame; the phase
+// table is recomputed only a few times per second.
+
+const int OVERLAY_FRAMES = 240;         // Frames in the graph and the stats
+const int OVERLAY_STATS_INTERVAL = 30;  // Frames between phase table updates
+
+class ProfilerOverlay : public sf::Drawable {
+public:
+    /**
+     * budgetMicroseconds is the frame time the graph is scaled against
+     */
+    ProfilerOverlay(const sf::Font& font, sf::Vector2f position, float budgetMicroseconds);
+
+    void update(const Profiler& profiler);
+
+private:
+    sf::Vector2f origin;
+    float budget;
+    sf::RectangleShape panel;
+    sf::VertexArray bars;       // Two vertices per frame
+    sf::VertexArray budgetLine;
+    sf::Text statsText;
+    int framesSinceStats;
+
+    void updateStats(const std::vector<FrameSample>& frames);
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "replay.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace std;
+
+static const char REPLAY_MAGIC[4] = {'M', 'R', 'P', 'L'};
+static const uint8_t REPLAY_VERSION = 2;   // 2: newGame() boards come from generate()
+static const uint8_t END_MARKER = 0xFF;
+static const uint8_t VERTICAL_FLAG = 0x40;
+
+/**
+ * Writes an unsigned value 7 bits at a time, low bits first
+ */
+static void writeVarint(ofstream& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.put(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.put(char(value));
+}
+
+static bool readVarint(ifstream& in, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int byte = in.get();
+        if (byte == EOF)
+            return false;
+        value |= uint32_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+Replay::Replay() {
+    seed = 0;
+    endTick = 0;
+    finalScore = 0;
+}
+
+void Replay::begin(uint64_t seedValue) {
+    seed = seedValue;
+    swaps.clear();
+    endTick = 0;
+    finalScore = 0;
+}
+
+void Replay::recordSwap(uint32_t tick, const Move& move) {
+    // Store every swap as going right or down from its first tile
+    Move stored = move;
+    if (move.row1 < move.row0 || move.col1 < move.col0)
+        stored = Move{move.row1, move.col1, move.row0, move.col0};
+    swaps.push_back(ReplaySwap{tick, stored});
+}
+
+void Replay::finish(uint32_t tick, int score) {
+    endTick = tick;
+    finalScore = score;
+}
+
+bool Replay::save(const string& path) const {
+    ofstream out(path, ios::binary);
+    if (!out)
+        return false;
+
+    out.write(REPLAY_MAGIC, 4);
+    out.put(char(REPLAY_VERSION));
+    for (int i = 0; i < 8; i++)
+        out.put(char(seed >> (8 * i)));
+
+    uint32_t lastTick = 0;
+    for (const ReplaySwap& swap : swaps) {
+        writeVarint(out, swap.tick - lastTick);
+        lastTick = swap.tick;
+
+        // Moves always go right or down from (row0, col0)
+        int cell = (swap.move.row0 - 1) * BOARD_SIZE + (swap.move.col0 - 1);
+        bool vertical = swap.move.row1 != swap.move.row0;
+        out.put(char(cell | (vertical ? VERTICAL_FLAG : 0)));
+    }
+
+    writeVarint(out, endTick - lastTick);
+    out.put(char(END_MARKER));
+    for (int i = 0; i < 4; i++)
+        out.put(char(uint32_t(finalScore) >> (8 * i)));
+
+    return bool(out);
+}
+
+bool Replay::load(const string& path) {
+    ifstream in(path, ios::binary);
+    char magic[4];
+    if (!in.read(magic, 4) || !equal(magic, magic + 4, REPLAY_MAGIC))
+        return false;
+    if (in.get() != REPLAY_VERSION)
+        return false;
+
+    begin(0);
+    for (int i = 0; i < 8; i++) {
+        int byte = in.get();
+        if (byte == EOF)
+            return false;
+        seed |= uint64_t(byte) << (8 * i);
+    }
+
+    uint32_t tick = 0;
+    while (true) {
+        uint32_t delta;
+        if (!readVarint(in, delta))
+            return false;
+        tick += delta;
+
+        int code = in.get();
+        if (code == EOF)
+            return false;
+
+        if (code == END_MARKER) {
+            uint32_t score = 0;
+            for (int i = 0; i < 4; i++) {
+                int byte = in.get();
+                if (byte == EOF)
+                    return false;
+                score |= uint32_t(byte) << (8 * i);
+            }
+            finish(tick, int(score));
+            return true;
+        }
+
+        // A swap must stay on the board: none down from the last row or
+        // right from the last column
+        int cell = code & ~VERTICAL_FLAG;
+        bool vertical = code & VERTICAL_FLAG;
+        if (cell >= BOARD_SIZE * BOARD_SIZE)
+            return false;
+        int row = cell / BOARD_SIZE + 1, col = cell % BOARD_SIZE + 1;
+        if (vertical ? row == BOARD_SIZE : col == BOARD_SIZE)
+            return false;
+        if (vertical)
+            recordSwap(tick, Move{row, col, row + 1, col});
+        else
+            recordSwap(tick, Move{row, col, row, col + 1});
+    }
+}
+
+int Replay::play(Board& board) const {
+    board.newGame(seed);
+    for (const ReplaySwap& swap : swaps) {
+        while (board.tickCount < swap.tick)
+            board.update();
+        board.beginSwap(swap.move.row0, swap.move.col0, swap.move.row1, swap.move.col1);
+    }
+    while (board.tickCount < endTick)
+        board.update();
+    return board.totalScore;
+}
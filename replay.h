@@ -0,0 +1,55 @@
+#ifndef MENAGERIE_REPLAY_H
+#define MENAGERIE_REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "board.h"
+
+// Session recording: the seed passed to Board::newGame() plus the logic tick
+// of every swap. Because all randomness comes from the board's RNG and logic
+// runs on fixed ticks, replaying the swaps on the same ticks reproduces the
+// session (and its final score) exactly, headless and at full speed.
+//
+// File layout (little endian):
+//   "MRPL"  u8 version  u64 seed
+//   per swap:  varint tick delta, u8 (cell index | 0x40 if vertical)
+//   end:       varint tick delta, u8 0xFF, i32 final score
+
+struct ReplaySwap {
+    uint32_t tick;      // Board::tickCount when the swap started
+    Move move;
+};
+
+class Replay {
+public:
+    uint64_t seed;
+    std::vector<ReplaySwap> swaps;
+    uint32_t endTick;
+    int finalScore;
+
+    Replay();
+
+    /**
+     * Starts a new recording for a game begun with Board::newGame(seed)
+     */
+    void begin(uint64_t seed);
+
+    void recordSwap(uint32_t tick, const Move& move);
+
+    /**
+     * Closes the recording at the given tick with the score reached
+     */
+    void finish(uint32_t tick, int score);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    /**
+     * Re-simulates the recording on a board without animation or display
+     * and returns the score it reaches
+     */
+    int play(Board& board) const;
+};
+
+#endif
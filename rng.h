@@ -0,0 +1,43 @@
+#ifndef MENAGERIE_RNG_H
+#define MENAGERIE_RNG_H
+
+#include <cstdint>
+
+// Small, fast, seedable random number generator (PCG32, XSH-RR variant).
+// Each board owns one, so a session is fully determined by its seed.
+
+class Rng {
+public:
+    explicit Rng(uint64_t seedValue = 1) {
+        seed(seedValue);
+    }
+
+    void seed(uint64_t seedValue) {
+        state = 0;
+        increment = (seedValue << 1) | 1;
+        next();
+        state += seedValue ^ 0x853C49E6748FEA9BULL;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t shifted = uint32_t(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = uint32_t(old >> 59);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    /**
+     * Uniform integer in [0, bound)
+     */
+    int below(int bound) {
+        return int((uint64_t(next()) * uint32_t(bound)) >> 32);
+    }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
+
+#endif
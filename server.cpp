@@ -0,0 +1,93 @@
+#include "session_server.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <sys/resource.h>
+#include <thread>
+
+using namespace std;
+
+// Headless session server: hosts any number of games for bots, tournaments
+// and load tests over a Unix socket, and prints throughput every few
+// seconds while clients are playing.
+//
+// Usage: server [socket path] [worker threads]
+
+const int STATS_SECONDS = 5;    // Interval between throughput reports
+
+static SessionServer* running = nullptr;
+
+static void stopServer(int) {
+    if (running)
+        running->stop();
+}
+
+/**
+ * CPU time (user + system) the process has used so far, in seconds
+ */
+static double cpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    string path = argc > 1 ? argv[1] : "menagerie.sock";
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+    SessionServer server(threads);
+    if (!server.listen(path)) {
+        cout << "Failed to listen on " << path << "\n";
+        return 1;
+    }
+    running = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    cout << "Serving on " << path << " with " << server.workers() << " workers\n";
+
+    // Reports come from their own thread, so the I/O thread never waits on
+    // the console. Cores used is CPU time over wall time; swaps per
+    // core-second and live sessions per core are what one core sustains.
+    atomic<bool> done(false);
+    thread reporter([&]() {
+        const ServerStats& stats = server.stats();
+        auto last = chrono::steady_clock::now();
+        double lastCpu = cpuSeconds();
+        long long lastSwaps = 0, lastRequests = 0;
+        while (!done) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            auto now = chrono::steady_clock::now();
+            double seconds = chrono::duration<double>(now - last).count();
+            if (seconds < STATS_SECONDS)
+                continue;
+
+            long long swaps = stats.swaps, requests = stats.requests;
+            double cpu = cpuSeconds();
+            if (requests != lastRequests) {
+                double cores = (cpu - lastCpu) / seconds;
+                long long live = stats.sessionsLive;
+                cout << "sessions: " << live << " live, " << stats.sessionsStarted << " started"
+                     << "  swaps/sec: " << (swaps - lastSwaps) / seconds
+                     << "  requests/sec: " << (requests - lastRequests) / seconds
+                     << "  cores: " << cores
+                     << "  swaps/core-sec: " << (cores > 0 ? (swaps - lastSwaps) / (cpu - lastCpu) : 0.0)
+                     << "  sessions/core: " << (cores > 0 ? live / cores : 0.0) << "\n";
+            }
+            last = now;
+            lastCpu = cpu;
+            lastSwaps = swaps;
+            lastRequests = requests;
+        }
+    });
+
+    bool served = server.run();
+    done = true;
+    reporter.join();
+    running = nullptr;
+
+    const ServerStats& stats = server.stats();
+    cout << "Served " << stats.sessionsStarted << " sessions, " << stats.swaps << " swaps\n";
+    return served ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#ifndef MENAGERIE_SESSION_PROTOCOL_H
+#define MENAGERIE_SESSION_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Wire protocol of the session server, shared by the server and its
+// clients. Every message is one frame over a Unix stream socket:
+//   u16 length (of what follows)  u8 type  payload
+// All integers are little endian. Swaps use the replay encoding: the cell
+// index of the first tile, | 0x40 if the swap goes down instead of right.
+// As in the game, every swap on the board uses a move, even one that makes
+// no match and is reverted.
+//
+// Client to server:
+//   NEW    u32 tag  u64 seed (0: server picks)  u16 seconds  u16 moves (0: no limit)
+//   SWAP   u32 session  u8 swap
+//   CLOSE  u32 session
+// Server to client:
+//   STARTED  u32 tag  u32 session  u64 seed  u8 width  u8 height  species per cell
+//   DELTA    u32 session  i32 points  i32 score  u16 moves left  u8 flags
+//            u8 count  count x (u8 cell, u8 species)
+//   ENDED    u32 session  i32 score  u16 moves played
+//   ERROR    u32 session (tag for NEW)  u8 error
+
+const int PROTOCOL_MAX_FRAME = 1024;    // Longest frame either side accepts
+
+enum MessageType {
+    MESSAGE_NEW = 0x01,
+    MESSAGE_SWAP = 0x02,
+    MESSAGE_CLOSE = 0x03,
+    MESSAGE_STARTED = 0x81,
+    MESSAGE_DELTA = 0x82,
+    MESSAGE_ENDED = 0x83,
+    MESSAGE_ERROR = 0x84
+};
+
+enum ProtocolError {
+    ERROR_UNKNOWN_SESSION = 1,
+    ERROR_BAD_SWAP = 2,
+    ERROR_BAD_MESSAGE = 3
+};
+
+const uint8_t SWAP_VERTICAL = 0x40;     // Swap with the tile below, not to the right
+const uint8_t DELTA_OVER = 0x01;        // Out of time or moves; later swaps are ignored
+
+/**
+ * Builds one frame in an output buffer: begin() reserves the length,
+ * finish() fills it in once the payload is written
+ */
+class FrameWriter {
+public:
+    explicit FrameWriter(std::vector<uint8_t>& out) : out(out), start(0) {}
+
+    void begin(uint8_t type) {
+        start = out.size();
+        out.push_back(0);
+        out.push_back(0);
+        out.push_back(type);
+    }
+
+    void put(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++)
+            out.push_back(uint8_t(value >> (8 * i)));
+    }
+
+    void finish() {
+        size_t length = out.size() - start - 2;
+        out[start] = uint8_t(length);
+        out[start + 1] = uint8_t(length >> 8);
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    size_t start;
+};
+
+/**
+ * Bounds-checked reader over one frame's payload
+ */
+struct FrameReader {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+
+    bool get(uint64_t& value, int bytes) {
+        if (size - position < size_t(bytes))
+            return false;
+        value = 0;
+        for (int i = 0; i < bytes; i++)
+            value |= uint64_t(data[position++]) << (8 * i);
+        return true;
+    }
+};
+
+/**
+ * Length of the first complete frame in a buffer, including its length
+ * field; 0 if the frame has not fully arrived
+ */
+inline size_t frameLength(const uint8_t* data, size_t size) {
+    if (size < 2)
+        return 0;
+    size_t length = 2 + (data[0] | size_t(data[1]) << 8);
+    return size >= length ? length : 0;
+}
+
+#endif
@@ -0,0 +1,482 @@
+#include "session_server.h"
+#include "session_protocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+const uint16_t NO_MOVE_LIMIT = 0xFFFF;  // Moves left as sent for an unlimited session
+
+// A client socket. Input and the session list belong to the I/O thread;
+// output is filled by workers and drained by the I/O thread.
+struct SessionServer::Connection {
+    int socket;
+    vector<uint8_t> input;
+    vector<uint32_t> owned;             // Sessions opened here and not yet closed
+
+    mutex outputLock;
+    vector<uint8_t> output;
+    bool closed;                        // Socket gone: replies are dropped
+};
+
+// One game. Only the worker draining the inbox touches the game state.
+struct SessionServer::Session {
+    uint32_t id;
+    shared_ptr<Connection> owner;
+
+    Board board;
+    int movesLeft;                      // -1: no limit
+    int movesPlayed;
+    bool timed;
+    chrono::steady_clock::time_point deadline;
+
+    mutex inboxLock;
+    vector<SessionRequest> inbox;
+    bool scheduled;                     // A worker is draining the inbox
+};
+
+static bool setNonBlocking(int descriptor) {
+    int flags = fcntl(descriptor, F_GETFL, 0);
+    return flags >= 0 && fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+SessionServer::SessionServer(int threadCount) : wakePending(false), stopping(false) {
+    pool.reset(new ThreadPool(threadCount));
+    listener = -1;
+    nextSession = 1;
+    seeds.seed(chrono::system_clock::now().time_since_epoch().count());
+
+    int ends[2] = {-1, -1};
+    if (pipe(ends) == 0) {
+        setNonBlocking(ends[0]);
+        setNonBlocking(ends[1]);
+    }
+    wakeRead = ends[0];
+    wakeWrite = ends[1];
+}
+
+SessionServer::~SessionServer() {
+    pool.reset();
+    for (const shared_ptr<Connection>& connection : connections)
+        close(connection->socket);
+    if (listener >= 0) {
+        close(listener);
+        unlink(socketPath.c_str());
+    }
+    if (wakeRead >= 0)
+        close(wakeRead);
+    if (wakeWrite >= 0)
+        close(wakeWrite);
+}
+
+bool SessionServer::listen(const string& path) {
+    sockaddr_un address = sockaddr_un();
+    if (wakeRead < 0 || listener >= 0 || path.size() >= sizeof(address.sun_path))
+        return false;
+
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (descriptor < 0)
+        return false;
+
+    // A socket file left by a server that died is in the way of bind()
+    unlink(path.c_str());
+    if (bind(descriptor, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(descriptor, SERVER_BACKLOG) != 0 || !setNonBlocking(descriptor)) {
+        close(descriptor);
+        return false;
+    }
+
+    // A client that hangs up mid-reply must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = descriptor;
+    socketPath = path;
+    return true;
+}
+
+bool SessionServer::run() {
+    vector<pollfd> polled;
+    while (!stopping) {
+        polled.clear();
+        polled.push_back(pollfd{listener, POLLIN, 0});
+        polled.push_back(pollfd{wakeRead, POLLIN, 0});
+        for (const shared_ptr<Connection>& connection : connections) {
+            // A client that does not read its replies gets no more served
+            short events = 0;
+            {
+                lock_guard<mutex> guard(connection->outputLock);
+                if (connection->output.size() < SERVER_MAX_OUTPUT)
+                    events |= POLLIN;
+                if (!connection->output.empty())
+                    events |= POLLOUT;
+            }
+            polled.push_back(pollfd{connection->socket, events, 0});
+        }
+
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        if (polled[1].revents & POLLIN) {
+            char bytes[64];
+            while (read(wakeRead, bytes, sizeof(bytes)) > 0) {}
+            wakePending.exchange(false);
+        }
+
+        // Read first, so replies the workers finish meanwhile go out in
+        // the same pass; drop dead sockets last to keep the indices valid
+        vector<size_t> dead;
+        for (size_t i = 0; i < connections.size(); i++) {
+            short events = polled[i + 2].revents;
+            if ((events & (POLLIN | POLLHUP | POLLERR)) && !readFrom(connections[i]))
+                dead.push_back(i);
+        }
+        for (size_t i = 0; i < connections.size(); i++)
+            if ((dead.empty() || find(dead.begin(), dead.end(), i) == dead.end()) && !flush(*connections[i]))
+                dead.push_back(i);
+        sort(dead.begin(), dead.end());
+        for (size_t i = dead.size(); i-- > 0;)
+            drop(dead[i]);
+
+        if (polled[0].revents & POLLIN)
+            accept();
+    }
+    return true;
+}
+
+void SessionServer::stop() {
+    stopping = true;
+    char byte = 0;
+    ssize_t written = write(wakeWrite, &byte, 1);
+    (void)written;
+}
+
+const ServerStats& SessionServer::stats() const {
+    return counters;
+}
+
+int SessionServer::workers() const {
+    return pool->size();
+}
+
+/**
+ * Wakes the I/O thread to write out new replies; one byte in the pipe is
+ * enough however many workers finish before it runs
+ */
+void SessionServer::wake() {
+    if (wakePending.exchange(true))
+        return;
+    char byte = 0;
+    ssize_t written = write(wakeWrite, &byte, 1);
+    (void)written;
+}
+
+void SessionServer::accept() {
+    for (;;) {
+        int descriptor = ::accept(listener, nullptr, nullptr);
+        if (descriptor < 0)
+            return;
+        if (!setNonBlocking(descriptor)) {
+            close(descriptor);
+            continue;
+        }
+
+        shared_ptr<Connection> connection = make_shared<Connection>();
+        connection->socket = descriptor;
+        connection->closed = false;
+        connections.push_back(connection);
+    }
+}
+
+/**
+ * Reads what the socket has and hands every complete frame on. Returns
+ * false once the client has gone or broke the protocol.
+ */
+bool SessionServer::readFrom(const shared_ptr<Connection>& connection) {
+    vector<uint8_t>& input = connection->input;
+    bool open = true;
+    size_t received = 0;
+    while (received < size_t(SERVER_READ_BYTES)) {
+        size_t used = input.size();
+        input.resize(used + 4096);
+        ssize_t count = recv(connection->socket, input.data() + used, 4096, 0);
+        input.resize(used + max<ssize_t>(count, 0));
+        if (count > 0) {
+            received += size_t(count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            open = false;
+        break;
+    }
+
+    size_t position = 0;
+    for (;;) {
+        const uint8_t* frame = input.data() + position;
+        size_t available = input.size() - position;
+        if (available >= 2 && (frame[0] | size_t(frame[1]) << 8) + 2 > size_t(PROTOCOL_MAX_FRAME))
+            return false;
+        size_t length = frameLength(frame, available);
+        if (!length)
+            break;
+        parse(connection, frame, length);
+        position += length;
+    }
+    input.erase(input.begin(), input.begin() + position);
+    return open;
+}
+
+/**
+ * Routes one frame: NEW opens a session, SWAP and CLOSE go to theirs
+ */
+void SessionServer::parse(const shared_ptr<Connection>& connection, const uint8_t* frame, size_t size) {
+    counters.requests++;
+    FrameReader reader{frame + 3, size > 3 ? size - 3 : 0, 0};
+    uint8_t type = size > 2 ? frame[2] : 0;
+
+    SessionRequest request = SessionRequest();
+    request.type = type;
+    uint64_t id = 0, value = 0;
+    bool valid = false;
+    if (type == MESSAGE_NEW) {
+        valid = reader.get(value, 4);
+        request.tag = uint32_t(value);
+        valid = valid && reader.get(request.seed, 8);
+        valid = valid && reader.get(value, 2);
+        request.seconds = uint16_t(value);
+        valid = valid && reader.get(value, 2);
+        request.moves = uint16_t(value);
+        id = request.tag;
+    } else if (type == MESSAGE_SWAP) {
+        valid = reader.get(id, 4) && reader.get(value, 1);
+        request.swap = uint8_t(value);
+    } else if (type == MESSAGE_CLOSE) {
+        valid = reader.get(id, 4);
+    }
+    if (!valid) {
+        sendError(*connection, uint32_t(id), ERROR_BAD_MESSAGE);
+        return;
+    }
+
+    if (type == MESSAGE_NEW) {
+        if (!request.seed)
+            request.seed = uint64_t(seeds.next()) << 32 | seeds.next();
+
+        shared_ptr<Session> session = make_shared<Session>();
+        session->id = nextSession++;
+        session->owner = connection;
+        session->scheduled = false;
+        sessions[session->id] = session;
+        connection->owned.push_back(session->id);
+        counters.sessionsStarted++;
+        counters.sessionsLive++;
+        submit(session, request);
+        return;
+    }
+
+    auto found = sessions.find(uint32_t(id));
+    if (found == sessions.end() || found->second->owner != connection) {
+        sendError(*connection, uint32_t(id), ERROR_UNKNOWN_SESSION);
+        return;
+    }
+    submit(found->second, request);
+
+    // Swaps sent after CLOSE find no session; the queued CLOSE still ends it
+    if (type == MESSAGE_CLOSE) {
+        sessions.erase(found);
+        vector<uint32_t>& owned = connection->owned;
+        owned.erase(std::find(owned.begin(), owned.end(), uint32_t(id)));
+        counters.sessionsLive--;
+    }
+}
+
+/**
+ * Queues a request on its session and schedules the session unless a
+ * worker is already draining it
+ */
+void SessionServer::submit(const shared_ptr<Session>& session, const SessionRequest& request) {
+    bool idle;
+    {
+        lock_guard<mutex> guard(session->inboxLock);
+        session->inbox.push_back(request);
+        idle = !session->scheduled;
+        session->scheduled = true;
+    }
+    if (idle)
+        pool->submit([this, session]() { drain(session); });
+}
+
+/**
+ * Closes a connection and forgets its sessions; work already queued for
+ * them finishes, but the replies go nowhere
+ */
+void SessionServer::drop(size_t index) {
+    shared_ptr<Connection> connection = connections[index];
+    {
+        lock_guard<mutex> guard(connection->outputLock);
+        connection->closed = true;
+        connection->output.clear();
+    }
+    close(connection->socket);
+    for (uint32_t id : connection->owned)
+        sessions.erase(id);
+    counters.sessionsLive -= (long long)connection->owned.size();
+    connections.erase(connections.begin() + index);
+}
+
+void SessionServer::sendError(Connection& connection, uint32_t id, uint8_t error) {
+    lock_guard<mutex> guard(connection.outputLock);
+    FrameWriter frame(connection.output);
+    frame.begin(MESSAGE_ERROR);
+    frame.put(id, 4);
+    frame.put(error, 1);
+    frame.finish();
+}
+
+/**
+ * Writes as much queued output as the socket takes; false on a dead socket
+ */
+bool SessionServer::flush(Connection& connection) {
+    lock_guard<mutex> guard(connection.outputLock);
+    size_t sent = 0;
+    while (sent < connection.output.size()) {
+        ssize_t count = send(connection.socket, connection.output.data() + sent, connection.output.size() - sent, 0);
+        if (count > 0) {
+            sent += size_t(count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        return false;
+    }
+    connection.output.erase(connection.output.begin(), connection.output.begin() + sent);
+    return true;
+}
+
+/**
+ * Plays every queued request of a session, in order, then hands the
+ * replies to the connection in one go per batch
+ */
+void SessionServer::drain(const shared_ptr<Session>& session) {
+    vector<SessionRequest> batch;
+    vector<uint8_t> replies;
+    for (;;) {
+        {
+            lock_guard<mutex> guard(session->inboxLock);
+            if (session->inbox.empty()) {
+                session->scheduled = false;
+                return;
+            }
+            batch.swap(session->inbox);
+        }
+
+        for (const SessionRequest& request : batch)
+            play(*session, request, replies);
+        batch.clear();
+
+        {
+            Connection& owner = *session->owner;
+            lock_guard<mutex> guard(owner.outputLock);
+            if (!owner.closed)
+                owner.output.insert(owner.output.end(), replies.begin(), replies.end());
+        }
+        replies.clear();
+        wake();
+    }
+}
+
+void SessionServer::play(Session& session, const SessionRequest& request, vector<uint8_t>& replies) {
+    Board& board = session.board;
+    FrameWriter frame(replies);
+
+    if (request.type == MESSAGE_NEW) {
+        board.newGame(request.seed);
+        session.movesLeft = request.moves ? request.moves : -1;
+        session.movesPlayed = 0;
+        session.timed = request.seconds > 0;
+        session.deadline = chrono::steady_clock::now() + chrono::seconds(request.seconds);
+
+        frame.begin(MESSAGE_STARTED);
+        frame.put(request.tag, 4);
+        frame.put(session.id, 4);
+        frame.put(request.seed, 8);
+        frame.put(Board::WIDTH, 1);
+        frame.put(Board::HEIGHT, 1);
+        for (int cell = 0; cell < Board::CELLS; cell++)
+            frame.put(board.species[cell], 1);
+        frame.finish();
+        return;
+    }
+
+    if (request.type == MESSAGE_CLOSE) {
+        frame.begin(MESSAGE_ENDED);
+        frame.put(session.id, 4);
+        frame.put(uint32_t(board.totalScore), 4);
+        frame.put(uint16_t(session.movesPlayed), 2);
+        frame.finish();
+        return;
+    }
+
+    // Swap: right or down from a cell, never off the board
+    int cell = request.swap & ~SWAP_VERTICAL;
+    bool vertical = request.swap & SWAP_VERTICAL;
+    int row = cell / Board::WIDTH + 1, col = cell % Board::WIDTH + 1;
+    if (cell >= Board::CELLS || (vertical ? row == Board::HEIGHT : col == Board::WIDTH)) {
+        frame.begin(MESSAGE_ERROR);
+        frame.put(session.id, 4);
+        frame.put(ERROR_BAD_SWAP, 1);
+        frame.finish();
+        return;
+    }
+
+    auto over = [&]() {
+        return session.movesLeft == 0 || (session.timed && chrono::steady_clock::now() >= session.deadline);
+    };
+
+    uint8_t before[Board::CELLS];
+    memcpy(before, board.species, sizeof(before));
+    int points = 0;
+    if (!over()) {
+        // As in the game, every swap uses a move, matching or not
+        points = vertical ? board.playSwap(row, col, row + 1, col) : board.playSwap(row, col, row, col + 1);
+        counters.swaps++;
+        session.movesPlayed++;
+        if (session.movesLeft > 0)
+            session.movesLeft--;
+    }
+
+    frame.begin(MESSAGE_DELTA);
+    frame.put(session.id, 4);
+    frame.put(uint32_t(points), 4);
+    frame.put(uint32_t(board.totalScore), 4);
+    frame.put(session.movesLeft < 0 ? NO_MOVE_LIMIT : uint16_t(session.movesLeft), 2);
+    frame.put(over() ? DELTA_OVER : 0, 1);
+    size_t countAt = replies.size();
+    frame.put(0, 1);
+    int changed = 0;
+    for (int i = 0; i < Board::CELLS; i++) {
+        if (board.species[i] == before[i])
+            continue;
+        frame.put(uint8_t(i), 1);
+        frame.put(board.species[i], 1);
+        changed++;
+    }
+    replies[countAt] = uint8_t(changed);
+    frame.finish();
+}
@@ -0,0 +1,108 @@
+#ifndef MENAGERIE_SESSION_SERVER_H
+#define MENAGERIE_SESSION_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "board.h"
+#include "rng.h"
+#include "thread_pool.h"
+
+// Headless game server: many independent sessions in one process, each
+// with its own board, score, move count and timer, driven by clients over
+// a Unix domain socket (see session_protocol.h). One I/O thread polls the
+// sockets, splits the input into requests and hands each to its session;
+// sessions run on a thread pool, at most one worker per session at a time,
+// so a session needs no locking of its own while different sessions play
+// in parallel. Replies are queued on their connection and written out by
+// the I/O thread.
+
+const int SERVER_BACKLOG = 64;                  // Connections waiting to be accepted
+const int SERVER_READ_BYTES = 64 * 1024;        // Read per socket per poll
+const size_t SERVER_MAX_OUTPUT = 4 << 20;       // Unsent replies before a client's requests wait
+
+// A request parsed off the wire, waiting for its session
+struct SessionRequest {
+    uint8_t type;
+    uint8_t swap;
+    uint16_t seconds, moves;
+    uint32_t tag;
+    uint64_t seed;
+};
+
+// Counters for throughput reports; read at any time from any thread
+struct ServerStats {
+    std::atomic<long long> sessionsStarted{0};
+    std::atomic<long long> sessionsLive{0};
+    std::atomic<long long> swaps{0};
+    std::atomic<long long> requests{0};
+};
+
+class SessionServer {
+public:
+    /**
+     * Runs sessions on threadCount workers (0: as ThreadPool)
+     */
+    explicit SessionServer(int threadCount = 0);
+    ~SessionServer();
+
+    SessionServer(const SessionServer&) = delete;
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    /**
+     * Binds and listens on a socket path, replacing a stale socket file
+     */
+    bool listen(const std::string& path);
+
+    /**
+     * Serves clients until stop(); returns false if polling failed
+     */
+    bool run();
+
+    /**
+     * Makes run() return; safe from other threads and signal handlers
+     */
+    void stop();
+
+    const ServerStats& stats() const;
+    int workers() const;
+
+private:
+    struct Connection;
+    struct Session;
+
+    std::unique_ptr<ThreadPool> pool;   // First to stop, so no worker outlives the rest
+    int listener;
+    std::string socketPath;
+    int wakeRead, wakeWrite;            // Self-pipe: workers have output, or stop()
+    std::atomic<bool> wakePending;
+    std::atomic<bool> stopping;
+
+    // I/O thread only
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::unordered_map<uint32_t, std::shared_ptr<Session>> sessions;
+    uint32_t nextSession;
+    Rng seeds;
+
+    ServerStats counters;
+
+    void wake();
+    void accept();
+    bool readFrom(const std::shared_ptr<Connection>& connection);
+    void parse(const std::shared_ptr<Connection>& connection, const uint8_t* frame, size_t size);
+    void submit(const std::shared_ptr<Session>& session, const SessionRequest& request);
+    void drop(size_t index);
+    static void sendError(Connection& connection, uint32_t id, uint8_t error);
+    static bool flush(Connection& connection);
+
+    // Worker side
+    void drain(const std::shared_ptr<Session>& session);
+    void play(Session& session, const SessionRequest& request, std::vector<uint8_t>& replies);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "board.h"
+#include "replay.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// Headless batch driver: plays random games on the board engine with no
+// window, rendering or audio and reports throughput and score statistics.
+//
+// Usage: simulate [games] [moves per game] [seed] [board size: 8, 9 or 10]
+//        simulate --replay file.mrp
+
+const char* const SIMULATE_USAGE =
+    "Usage: simulate [games] [moves per game] [seed] [board size: 8, 9 or 10]\n"
+    "       simulate --replay file.mrp\n";
+
+/**
+ * Re-simulates a recorded session and checks it reaches the recorded score
+ */
+static int playReplay(const char* path) {
+    Replay replay;
+    if (!replay.load(path)) {
+        cout << "Failed to load " << path << "\n";
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    Board board;
+    int score = replay.play(board);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "seed:         " << replay.seed << "\n";
+    cout << "swaps:        " << replay.swaps.size() << "\n";
+    cout << "ticks:        " << replay.endTick << "\n";
+    cout << "recorded:     " << replay.finalScore << "\n";
+    cout << "reproduced:   " << score << "\n";
+    cout << "elapsed:      " << seconds << " s\n";
+    cout << "ticks/sec:    " << (seconds > 0 ? replay.endTick / seconds : 0.0) << "\n";
+    return score == replay.finalScore ? 0 : 1;
+}
+
+/**
+ * Plays random swaps on boards of one size and prints the statistics
+ */
+template<typename BoardType>
+static int simulate(long long games, int movesPerGame, uint64_t seed) {
+    Rng picker(seed);   // Picks the swaps; each board gets its own seed
+
+    long long swaps = 0, validSwaps = 0, scoreSum = 0, reshuffles = 0;
+    int bestScore = 0, bestCombo = 0;
+
+    auto start = chrono::steady_clock::now();
+
+    BoardType board;
+    for (long long game = 0; game < games; game++) {
+        board.newGame(picker.next());
+
+        for (int move = 0; move < movesPerGame; move++) {
+            // Random adjacent swap: right or down from a random tile
+            int row = picker.below(BoardType::HEIGHT) + 1;
+            int col = picker.below(BoardType::WIDTH) + 1;
+            bool horizontal = picker.below(2);
+            if (horizontal && col == BoardType::WIDTH) col--;
+            if (!horizontal && row == BoardType::HEIGHT) row--;
+
+            int points = horizontal ? board.playSwap(row, col, row, col + 1)
+                                    : board.playSwap(row, col, row + 1, col);
+            swaps++;
+            if (points > 0) validSwaps++;
+        }
+
+        scoreSum += board.totalScore;
+        if (board.totalScore > bestScore) bestScore = board.totalScore;
+        if (board.maxCombo > bestCombo) bestCombo = board.maxCombo;
+        reshuffles += board.reshuffleCount;
+        board.reshuffleCount = 0;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "board:        " << BoardType::WIDTH << "x" << BoardType::HEIGHT << "\n";
+    cout << "games:        " << games << "\n";
+    cout << "swaps:        " << swaps << " (" << validSwaps << " valid)\n";
+    cout << "mean score:   " << (games ? (double)scoreSum / games : 0.0) << "\n";
+    cout << "best score:   " << bestScore << "\n";
+    cout << "best combo:   " << bestCombo << "\n";
+    cout << "reshuffles:   " << reshuffles << "\n";
+    cout << "elapsed:      " << seconds << " s\n";
+    cout << "swaps/sec:    " << (seconds > 0 ? swaps / seconds : 0.0) << "\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+        return playReplay(argv[2]);
+
+    long long games = argc > 1 ? atoll(argv[1]) : 100000;
+    int movesPerGame = argc > 2 ? atoi(argv[2]) : 10;
+    uint64_t seed = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+    int size = argc > 4 ? atoi(argv[4]) : BOARD_SIZE;
+    if (games < 1 || movesPerGame < 1) {
+        cout << SIMULATE_USAGE;
+        return 1;
+    }
+
+    switch (size) {
+    case 8:
+        return simulate<BasicBoard<8, 8, SPECIES_COUNT>>(games, movesPerGame, seed);
+    case 9:
+        return simulate<BasicBoard<9, 9, SPECIES_COUNT>>(games, movesPerGame, seed);
+    case 10:
+        return simulate<BasicBoard<10, 10, SPECIES_COUNT>>(games, movesPerGame, seed);
+    default:
+        cout << "Unsupported board size " << size << " (8, 9 or 10)\n" << SIMULATE_USAGE;
+        return 1;
+    }
+}
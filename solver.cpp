@@ -0,0 +1,184 @@
+#include "solver.h"
+#include <cmath>
+
+using namespace std;
+
+/**
+ * SplitMix64 finaliser: spreads (search, candidate, rollout) into
+ * independent refill seeds
+ */
+static uint64_t mixSeed(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+Solver::Solver(int threadCount) : pool(threadCount) {
+    searchCount = 0;
+}
+
+Solver::~Solver() {
+    cancel();
+}
+
+void Solver::start(const Board& board, int depth) {
+    cancel();
+
+    shared_ptr<Search> search = make_shared<Search>();
+    search->root = board;
+    search->depth = depth;
+    search->seed = mixSeed(++searchCount);
+    search->cancelled = false;
+    search->started = chrono::steady_clock::now();
+
+    Move moves[Board::MAX_MOVES];
+    int count = board.findMoves(moves);
+    search->moves.assign(moves, moves + count);
+    search->stats.reset(new MoveStats[count]);
+    search->remaining = count;
+
+    // Candidates evaluated before at this depth are settled from the cache
+    PackedBoard root = board.pack();
+    vector<int> unsettled;
+    for (int i = 0; i < count; i++) {
+        const Move& move = moves[i];
+        int species0 = board.speciesAt(move.row0, move.col0);
+        int species1 = board.speciesAt(move.row1, move.col1);
+        PackedBoard after = root;
+        after.setSpecies(move.row0, move.col0, species1);
+        after.setSpecies(move.row1, move.col1, species0);
+        uint64_t hash = board.hash ^
+                        Board::zobristKey(move.row0, move.col0, species0) ^ Board::zobristKey(move.row1, move.col1, species1) ^
+                        Board::zobristKey(move.row0, move.col0, species1) ^ Board::zobristKey(move.row1, move.col1, species0);
+        search->positions.push_back(after);
+        search->hashes.push_back(hash);
+
+        MoveStats& stats = search->stats[i];
+        float mean;
+        int cachedDepth;
+        if (cache.probe(after, hash, mean, cachedDepth) && cachedDepth == depth) {
+            stats.total = llround(double(mean) * SOLVER_ROLLOUTS_PER_MOVE);
+            stats.count = SOLVER_ROLLOUTS_PER_MOVE;
+            stats.claimed = SOLVER_ROLLOUTS_PER_MOVE;
+            search->remaining--;
+        } else {
+            stats.total = 0;
+            stats.count = 0;
+            stats.claimed = 0;
+            unsettled.push_back(i);
+        }
+    }
+    current = search;
+
+    // Two tasks per candidate keep every worker busy on typical boards;
+    // each task re-queues itself until its candidate has all its rollouts
+    vector<function<void()>> tasks;
+    for (int repeat = 0; repeat < 2; repeat++)
+        for (int i : unsettled)
+            tasks.push_back(batchTask(search, i));
+    pool.submit(tasks);
+}
+
+void Solver::cancel() {
+    if (current)
+        current->cancelled = true;
+    current.reset();
+}
+
+bool Solver::best(Move& move) const {
+    if (!current)
+        return false;
+
+    bool found = false;
+    double bestMean = 0;
+    for (size_t i = 0; i < current->moves.size(); i++) {
+        const MoveStats& stats = current->stats[i];
+        int count = stats.count;
+        if (count < SOLVER_BATCH)
+            continue;
+
+        double mean = double(stats.total) / count;
+        if (!found || mean > bestMean) {
+            bestMean = mean;
+            move = current->moves[i];
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool Solver::isDone() const {
+    return current && current->remaining == 0;
+}
+
+int Solver::rollouts() const {
+    if (!current)
+        return 0;
+
+    int total = 0;
+    for (size_t i = 0; i < current->moves.size(); i++)
+        total += current->stats[i].count;
+    return total;
+}
+
+float Solver::searchSeconds() const {
+    if (!current)
+        return 0;
+    return chrono::duration<float>(chrono::steady_clock::now() - current->started).count();
+}
+
+/**
+ * One batch of rollouts for a candidate; the batch re-queues itself on the
+ * same worker until the candidate is settled or the search dropped
+ */
+function<void()> Solver::batchTask(shared_ptr<Search> search, int candidate) {
+    return [this, search, candidate] {
+        if (search->cancelled)
+            return;
+
+        MoveStats& stats = search->stats[candidate];
+        int first = stats.claimed.fetch_add(SOLVER_BATCH);
+        if (first >= SOLVER_ROLLOUTS_PER_MOVE)
+            return;
+
+        long long total = 0;
+        for (int i = 0; i < SOLVER_BATCH; i++) {
+            uint64_t seed = mixSeed(search->seed ^ (uint64_t(candidate) << 32) ^ uint64_t(first + i));
+            total += rollout(*search, candidate, seed);
+        }
+        stats.total += total;
+        if (stats.count.fetch_add(SOLVER_BATCH) + SOLVER_BATCH >= SOLVER_ROLLOUTS_PER_MOVE) {
+            float mean = float(double(stats.total) / SOLVER_ROLLOUTS_PER_MOVE);
+            cache.store(search->positions[candidate], search->hashes[candidate], mean, search->depth);
+            search->remaining--;
+            return;
+        }
+
+        if (!search->cancelled)
+            pool.submit(batchTask(search, candidate));
+    };
+}
+
+/**
+ * Plays the candidate and then random valid swaps up to the search depth
+ * on a copy of the root board, with refills drawn from the given seed
+ */
+int Solver::rollout(const Search& search, int candidate, uint64_t seed) {
+    Board board = search.root;
+    board.rng.seed(seed);
+    Rng policy(mixSeed(seed));
+
+    const Move& move = search.moves[candidate];
+    int score = board.playSwap(move.row0, move.col0, move.row1, move.col1);
+
+    Move moves[Board::MAX_MOVES];
+    for (int step = 1; step < search.depth; step++) {
+        int count = board.findMoves(moves);
+        if (!count)
+            break;
+        const Move& next = moves[policy.below(count)];
+        score += board.playSwap(next.row0, next.col0, next.row1, next.col1);
+    }
+    return score;
+}
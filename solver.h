@@ -0,0 +1,90 @@
+#ifndef MENAGERIE_SOLVER_H
+#define MENAGERIE_SOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "board.h"
+#include "thread_pool.h"
+#include "transposition.h"
+
+// Monte Carlo lookahead for hints and autoplay. For every swap that makes a
+// match, the solver plays many randomised rollouts on copies of the board:
+// the swap itself, then random valid swaps up to the lookahead depth, each
+// with its own refill seed. The swap with the best mean score wins.
+//
+// Rollouts run on a work-stealing pool in the background. start() and
+// cancel() return immediately and best() never waits, so the caller always
+// has a best-so-far answer without stalling its frame.
+//
+// A candidate's settled mean is cached under the position right after its
+// swap, so a board seen before (a reverted swap, a transposition reached
+// another way) reuses it instead of rolling out again.
+
+const int SOLVER_DEPTH = 3;                 // Swaps per rollout, including the candidate
+const int SOLVER_ROLLOUTS_PER_MOVE = 4000;  // Rollouts before a candidate is settled
+const int SOLVER_BATCH = 16;                // Rollouts per pool task
+
+class Solver {
+public:
+    explicit Solver(int threadCount = 0);
+    ~Solver();
+
+    /**
+     * Drops any running search and starts one on a copy of the board
+     */
+    void start(const Board& board, int depth = SOLVER_DEPTH);
+
+    /**
+     * Drops the running search; tasks already running finish their batch
+     */
+    void cancel();
+
+    /**
+     * Best swap found so far; false until some rollouts have completed
+     */
+    bool best(Move& move) const;
+
+    /**
+     * True once every candidate has all its rollouts
+     */
+    bool isDone() const;
+
+    int rollouts() const;
+    float searchSeconds() const;
+
+private:
+    // Running totals for one candidate swap
+    struct MoveStats {
+        std::atomic<long long> total;
+        std::atomic<int> count;     // Rollouts finished
+        std::atomic<int> claimed;   // Rollouts handed out to batches
+    };
+
+    // One search; tasks hold a reference, so a dropped search stays valid
+    // until its last batch returns
+    struct Search {
+        Board root;
+        int depth;
+        uint64_t seed;
+        std::vector<Move> moves;
+        std::vector<PackedBoard> positions;     // Layout after each candidate swap
+        std::vector<uint64_t> hashes;
+        std::unique_ptr<MoveStats[]> stats;
+        std::atomic<int> remaining;     // Candidates still short of rollouts
+        std::atomic<bool> cancelled;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    TranspositionTable cache;
+    std::shared_ptr<Search> current;    // Only touched by the owning thread
+    uint64_t searchCount;
+    ThreadPool pool;                    // Last, so the workers stop before the rest goes
+
+    std::function<void()> batchTask(std::shared_ptr<Search> search, int candidate);
+    static int rollout(const Search& search, int candidate, uint64_t seed);
+};
+
+#endif
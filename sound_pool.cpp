@@ -0,0 +1,82 @@
+#include "sound_pool.h"
+
+SoundPool::SoundPool() {
+    for (int effect = 0; effect < SOUND_EFFECT_COUNT; effect++)
+        buffers[effect] = nullptr;
+    for (Voice& voice : voices) {
+        voice.effect = -1;
+        voice.started = 0;
+    }
+    queued = 0;
+    startCount = 0;
+}
+
+void SoundPool::setBuffer(SoundEffect effect, const sf::SoundBuffer& buffer) {
+    buffers[effect] = &buffer;
+}
+
+void SoundPool::trigger(SoundEffect effect) {
+    if (!buffers[effect])
+        return;
+    for (int i = 0; i < queued; i++)
+        if (queue[i] == effect)
+            return;
+
+    // Insert behind every trigger of the same or higher priority
+    int priority = SOUND_CATEGORIES[effect].priority;
+    int position = queued++;
+    while (position > 0 && SOUND_CATEGORIES[queue[position - 1]].priority < priority) {
+        queue[position] = queue[position - 1];
+        position--;
+    }
+    queue[position] = effect;
+}
+
+void SoundPool::flush() {
+    for (int i = 0; i < queued; i++) {
+        SoundEffect effect = queue[i];
+        Voice* voice = chooseVoice(effect);
+        if (!voice)
+            continue;
+
+        voice->sound.stop();
+        voice->sound.setBuffer(*buffers[effect]);
+        voice->effect = effect;
+        voice->started = startCount++;
+        voice->sound.play();
+    }
+    queued = 0;
+}
+
+/**
+ * Voice for a new sound of an effect: its own oldest voice once it is at its
+ * limit, else a free voice, else the oldest voice playing an effect of the
+ * same or lower priority. nullptr if every voice is taken by a higher one.
+ */
+SoundPool::Voice* SoundPool::chooseVoice(SoundEffect effect) {
+    int priority = SOUND_CATEGORIES[effect].priority;
+    int playing = 0;
+    Voice* freeVoice = nullptr;
+    Voice* oldestOwn = nullptr;
+    Voice* oldestStealable = nullptr;
+
+    for (Voice& voice : voices) {
+        if (voice.effect < 0 || voice.sound.getStatus() == sf::Sound::Stopped) {
+            if (!freeVoice)
+                freeVoice = &voice;
+            continue;
+        }
+        if (voice.effect == effect) {
+            playing++;
+            if (!oldestOwn || voice.started < oldestOwn->started)
+                oldestOwn = &voice;
+        }
+        if (SOUND_CATEGORIES[voice.effect].priority <= priority &&
+            (!oldestStealable || voice.started < oldestStealable->started))
+            oldestStealable = &voice;
+    }
+
+    if (playing >= SOUND_CATEGORIES[effect].maxVoices)
+        return oldestOwn;
+    return freeVoice ? freeVoice : oldestStealable;
+}
@@ -0,0 +1,70 @@
+#ifndef MENAGERIE_SOUND_POOL_H
+#define MENAGERIE_SOUND_POOL_H
+
+#include <SFML/Audio.hpp>
+
+// Polyphonic sound effects. A fixed set of voices is allocated up front and
+// shared by every effect. Game logic queues triggers during the frame and
+// flush() starts them once per frame, highest priority first. Each effect
+// may hold a limited number of voices at once; at that limit its oldest
+// voice is restarted, and when every voice is busy the oldest one playing
+// an effect of the same or lower priority is stolen.
+
+enum SoundEffect {
+    SOUND_MATCH,
+    SOUND_CLICK,
+    SOUND_GAMEOVER,
+    SOUND_EFFECT_COUNT
+};
+
+// Mixing rules of one effect
+struct SoundCategory {
+    int maxVoices;      // Voices the effect may hold at once
+    int priority;       // Higher may steal voices from lower
+};
+
+const SoundCategory SOUND_CATEGORIES[SOUND_EFFECT_COUNT] = {
+    {4, 1},     // Match: cascades layer up to four
+    {2, 1},     // Click
+    {1, 2},     // Game over: never stolen
+};
+const int SOUND_VOICES = 8;     // Voices allocated up front
+
+class SoundPool {
+public:
+    SoundPool();
+
+    /**
+     * Buffer an effect plays; triggers of effects without one are ignored
+     */
+    void setBuffer(SoundEffect effect, const sf::SoundBuffer& buffer);
+
+    /**
+     * Queues an effect to start at the next flush. An effect already
+     * queued is not queued again.
+     */
+    void trigger(SoundEffect effect);
+
+    /**
+     * Starts the queued effects, highest priority first
+     */
+    void flush();
+
+private:
+    // A preallocated sound and what it last played
+    struct Voice {
+        sf::Sound sound;
+        int effect;                 // -1 until first used
+        unsigned long started;      // Start order, to find the oldest voice
+    };
+
+    const sf::SoundBuffer* buffers[SOUND_EFFECT_COUNT];
+    Voice voices[SOUND_VOICES];
+    SoundEffect queue[SOUND_EFFECT_COUNT];  // Pending triggers, highest priority first
+    int queued;
+    unsigned long startCount;
+
+    Voice* chooseVoice(SoundEffect effect);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef MENAGERIE_SPSC_QUEUE_H
+#define MENAGERIE_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Bounded lock-free queue for one producer and one consumer. Items live in
+// a fixed ring; the producer only advances the tail and the consumer only
+// the head, each on its own cache line. Capacity must be a power of two.
+
+template<typename T, uint32_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * Producer: appends an item; false if the queue is full
+     */
+    bool push(const T& item) {
+        uint32_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[position & (Capacity - 1)] = item;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer: takes the oldest item; false if the queue is empty
+     */
+    bool pop(T& item) {
+        uint32_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[position & (Capacity - 1)];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[Capacity];
+    alignas(64) std::atomic<uint32_t> head;     // Next item to pop
+    alignas(64) std::atomic<uint32_t> tail;     // Next free slot
+};
+
+#endif
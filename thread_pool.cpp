@@ -0,0 +1,102 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+using namespace std;
+
+// Index of the worker running on this thread (-1 outside the pool)
+static thread_local int workerIndex = -1;
+static thread_local const ThreadPool* workerPool = nullptr;
+
+ThreadPool::ThreadPool(int threadCount) : pending(0), nextQueue(0), stopping(false) {
+    if (threadCount <= 0)
+        threadCount = max(1, int(thread::hardware_concurrency()) - 1);
+
+    for (int i = 0; i < threadCount; i++)
+        queues.emplace_back(new WorkQueue());
+    for (int i = 0; i < threadCount; i++)
+        threads.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& worker : threads)
+        worker.join();
+}
+
+void ThreadPool::submit(function<void()> task) {
+    int target = workerPool == this ? workerIndex : int(nextQueue++ % queues.size());
+    {
+        lock_guard<mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(move(task));
+    }
+    pending++;
+
+    // Taking the lock orders this notify after a worker's last check of
+    // pending, so the wake-up cannot be lost
+    { lock_guard<mutex> guard(sleepLock); }
+    wake.notify_one();
+}
+
+void ThreadPool::submit(vector<function<void()>>& tasks) {
+    for (function<void()>& task : tasks) {
+        int target = int(nextQueue++ % queues.size());
+        lock_guard<mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(move(task));
+    }
+    pending += int(tasks.size());
+    tasks.clear();
+
+    { lock_guard<mutex> guard(sleepLock); }
+    wake.notify_all();
+}
+
+int ThreadPool::size() const {
+    return int(threads.size());
+}
+
+/**
+ * Pops the newest task of the worker's own queue, or steals the oldest
+ * task of another worker
+ */
+bool ThreadPool::take(int self, function<void()>& task) {
+    int count = int(queues.size());
+    for (int i = 0; i < count; i++) {
+        int victim = (self + i) % count;
+        WorkQueue& queue = *queues[victim];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+            continue;
+
+        if (victim == self) {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        pending--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int self) {
+    workerIndex = self;
+    workerPool = this;
+
+    function<void()> task;
+    while (!stopping) {
+        if (take(self, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        unique_lock<mutex> guard(sleepLock);
+        wake.wait(guard, [this] { return stopping || pending > 0; });
+    }
+}
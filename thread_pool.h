@@ -0,0 +1,61 @@
+#ifndef MENAGERIE_THREAD_POOL_H
+#define MENAGERIE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker has its own task queue: it takes
+// work from the back of its own queue (newest first, still warm in cache)
+// and, when that runs dry, steals from the front of the others. Tasks a
+// worker submits go to its own queue; tasks from other threads are spread
+// round robin. Idle workers sleep until work arrives.
+
+class ThreadPool {
+public:
+    /**
+     * Starts threadCount workers; 0 uses every hardware thread but one,
+     * leaving a core for the render loop
+     */
+    explicit ThreadPool(int threadCount = 0);
+
+    /**
+     * Stops the workers; tasks still queued are dropped
+     */
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+
+    /**
+     * Queues several tasks and wakes the workers once, so the submitting
+     * thread is not preempted task by task
+     */
+    void submit(std::vector<std::function<void()>>& tasks);
+
+    int size() const;
+
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<int> pending;           // Tasks queued but not yet taken
+    std::atomic<unsigned> nextQueue;    // Round robin for outside submits
+    std::atomic<bool> stopping;
+
+    bool take(int self, std::function<void()>& task);
+    void run(int self);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "transposition.h"
+
+using namespace std;
+
+TranspositionTable::TranspositionTable(int sizeLog2)
+    : slots(new Slot[size_t(1) << sizeLog2]),
+      mask((uint64_t(1) << sizeLog2) - 1),
+      probeCount(0),
+      hitCount(0) {
+    clear();
+}
+
+bool TranspositionTable::probe(const PackedBoard& board, uint64_t hash, float& value, int& depth) const {
+    probeCount.fetch_add(1, memory_order_relaxed);
+    const Slot& slot = slots[hash & mask];
+
+    uint32_t before = slot.sequence.load(memory_order_acquire);
+    if (before & 1)
+        return false;
+
+    int32_t storedDepth = slot.depth.load(memory_order_relaxed);
+    float storedValue = slot.value.load(memory_order_relaxed);
+    bool same = slot.hash.load(memory_order_relaxed) == hash &&
+                slot.planes[0].load(memory_order_relaxed) == board.planes[0] &&
+                slot.planes[1].load(memory_order_relaxed) == board.planes[1] &&
+                slot.planes[2].load(memory_order_relaxed) == board.planes[2];
+
+    // A writer got in while the fields were read: treat it as a miss
+    atomic_thread_fence(memory_order_acquire);
+    if (slot.sequence.load(memory_order_relaxed) != before)
+        return false;
+    if (!same || storedDepth == 0)
+        return false;
+
+    value = storedValue;
+    depth = storedDepth;
+    hitCount.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void TranspositionTable::store(const PackedBoard& board, uint64_t hash, float value, int depth) {
+    Slot& slot = slots[hash & mask];
+
+    uint32_t sequence = slot.sequence.load(memory_order_relaxed);
+    if (sequence & 1)
+        return;
+    if (slot.hash.load(memory_order_relaxed) == hash && slot.depth.load(memory_order_relaxed) > depth)
+        return;
+    if (!slot.sequence.compare_exchange_strong(sequence, sequence + 1, memory_order_acquire))
+        return;
+
+    slot.depth.store(depth, memory_order_relaxed);
+    slot.value.store(value, memory_order_relaxed);
+    slot.hash.store(hash, memory_order_relaxed);
+    for (int plane = 0; plane < 3; plane++)
+        slot.planes[plane].store(board.planes[plane], memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, memory_order_release);
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; i <= mask; i++) {
+        slots[i].sequence = 0;
+        slots[i].depth = 0;
+        slots[i].value = 0;
+        slots[i].hash = 0;
+        for (int plane = 0; plane < 3; plane++)
+            slots[i].planes[plane] = 0;
+    }
+    probeCount = 0;
+    hitCount = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef MENAGERIE_TRANSPOSITION_H
+#define MENAGERIE_TRANSPOSITION_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "board.h"
+
+// Bounded cache of evaluated positions, keyed on the packed layout and
+// indexed by its Zobrist hash. Any number of threads may probe and store at
+// once without locks: each slot is a seqlock, a reader that catches a slot
+// mid-write counts it as a miss and a writer that finds a slot busy drops
+// its entry. A probe only hits on an exact layout match.
+
+class TranspositionTable {
+public:
+    /**
+     * A table of 2^sizeLog2 slots (48 bytes each)
+     */
+    explicit TranspositionTable(int sizeLog2 = 16);
+
+    /**
+     * Looks up a position; on a hit returns its value and the search depth
+     * it was evaluated at
+     */
+    bool probe(const PackedBoard& board, uint64_t hash, float& value, int& depth) const;
+
+    /**
+     * Caches a position's value. A slot holding the same position from a
+     * deeper search is kept; anything else is replaced.
+     */
+    void store(const PackedBoard& board, uint64_t hash, float value, int depth);
+
+    void clear();
+
+    // Probe counters, for tuning the table size
+    uint64_t probes() const { return probeCount; }
+    uint64_t hits() const { return hitCount; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;     // Odd while a writer is busy
+        std::atomic<int32_t> depth;         // 0 = empty
+        std::atomic<float> value;
+        std::atomic<uint64_t> hash;
+        std::atomic<uint64_t> planes[3];
+    };
+    static_assert(sizeof(Slot) == 48, "table sizes in the docs assume 48-byte slots");
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask;
+    mutable std::atomic<uint64_t> probeCount;
+    mutable std::atomic<uint64_t> hitCount;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MENAGERIE_TRIPLE_BUFFER_H
+#define MENAGERIE_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free triple buffer for one writer and one reader. The writer fills
+// its back slot and publishes it by swapping it with the middle slot; the
+// reader takes the newest published value by swapping its front slot with
+// the middle one. Neither side ever waits for the other, the reader always
+// sees a complete value, and values it was too slow for are skipped.
+
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * Writer: the slot to fill before the next publish(). It holds an
+     * older value, so every field has to be written.
+     */
+    T& writeBuffer() {
+        return slots[back];
+    }
+
+    /**
+     * Writer: makes the write buffer the newest value
+     */
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & SLOT_MASK;
+    }
+
+    /**
+     * Reader: moves to the newest value if one was published since the
+     * last call; false if readBuffer() is already the newest
+     */
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & SLOT_MASK;
+        return true;
+    }
+
+    /**
+     * Reader: the value taken by the last update()
+     */
+    const T& readBuffer() const {
+        return slots[front];
+    }
+
+private:
+    static const int SLOT_MASK = 3;
+    static const int FRESH = 4;         // The middle slot was published and not yet read
+
+    T slots[3] {};                      // Value-initialised, so the reader starts from a blank value
+    alignas(64) int back;               // Writer's slot
+    alignas(64) std::atomic<int> middle;
+    alignas(64) int front;              // Reader's slot
+};
+
+#endif